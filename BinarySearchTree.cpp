@@ -6,7 +6,29 @@
 #include <iostream>
 #include <time.h>
 #include <fstream>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include "CSVparser.hpp"
+#include "Course.hpp"
+#include "CatalogTree.hpp"
+#include "InvertedIndex.hpp"
+#include "FuzzyIndex.hpp"
+#include "PrereqGraph.hpp"
+#include "DependentIndex.hpp"
+#include "CatalogExport.hpp"
+#include "CourseColumns.hpp"
+#include "ResultCache.hpp"
+#include "CatalogServer.hpp"
+#include "BloomFilter.hpp"
+#include "CatalogJournal.hpp"
+#include <csignal>
 
 using namespace std;
 
@@ -17,272 +39,693 @@ using namespace std;
 // forward declarations
 double strToDouble(string str, char ch);
 
-// define a structure to hold course information
-struct Course {
-    string courseNum; // unique identifier
-    string courseName;
-    vector<string> prereqs;
-    Course() {
+// Course information as displayed
+
+string formatCourse(const Course& course) {
+    stringstream out;
+    out << course.courseNum << ": " << course.courseName << "  " << endl;
+    out << "Prerequisites: ";
+    if (course.prereqs.size() == 0) {
+        out << "No prerequisites" << endl;
     }
-};
+    else {
+        for (int i = 0; i < course.prereqs.size(); i++) {
+            out << course.prereqs[i] << " ";
+        }
+        out << endl;
+    }
+    const char* labels[COLUMN_COUNT] = { "Credits: ", "Enrollment cap: ", "Fee: $" };
+    for (int i = 0; i < course.attributes.size() && i < COLUMN_COUNT; i++) {
+        double value;
+        if (parseNumberField(course.attributes[i], &value)) {
+            out << labels[i] << value << endl;
+        }
+    }
+    return out.str();
+}
 
-// Internal structure for tree node
-struct Node {
-    Course course;
-    Node *left;
-    Node *right;
+// Display course information
 
-    // default constructor
-    Node() {
-        left = nullptr;
-        right = nullptr;
-    }
+void displayCourse(Course course) {
+    cout << formatCourse(course);
+    return;
+}
 
-    // initialize with a course
-    Node(Course aCourse) :
-            Node() {
-        course = aCourse;
-    }
-};
+// Row hashes remembered from the previous load so a reload only touches
+// the courses whose line in the CSV actually changed
+//
+// Loads run on a background thread. lock guards the tree, the indices and
+// pending against the menu. rowHashes is used by the loader and by edits
+// from the menu, which wait until no load is running.
+struct Catalog {
+    CatalogTree* tree;              // plain BST or radix tree, picked at startup
+    unordered_map<string, uint64_t> rowHashes;
+    InvertedIndex names;
+    FuzzyIndex fuzzy;
+    CourseColumns columns;          // credits, cap and fee by course id
+    uint64_t generation;            // bumped by every change to the tree
+    ResultCache display;            // formatted courses, valid for one generation
+    BloomFilter filter;             // every course number, rebuilt on each load
+    DependentIndex dependents;      // who needs a course, directly or not
+
+    shared_mutex lock;
+    unordered_set<string> pending;  // in the file being loaded, not in the tree yet
+    bool reading;                   // file not diffed yet, so pending is not known
+    thread loader;
+    atomic<bool> loading;
+    string loadReport;              // set when a load finishes, shown by the menu
 
-// Binary Search Tree class definition
+    CatalogJournal journal;         // snapshot and edit log next to the CSV
+    mutex compaction;               // one snapshot written at a time
+    thread compactor;
+    atomic<bool> compacting;
 
-class BinarySearchTree {
+    Catalog() : loading(false), compacting(false) {
+        tree = nullptr;
+        reading = false;
+        generation = 0;
+    }
+};
 
-private:
-    Node* root;
+// how many changes a load applies per write lock, lookups run in between
+const int LOAD_BATCH = 256;
 
-    void addNode(Node* node, Course course);
-    void inOrder(Node* node);
-    Node* removeNode(Node* node, string courseNum);
+// how large the edit log may grow before it is folded into a new snapshot
+const uint64_t COMPACT_LOG_BYTES = 1 << 20;
 
-public:
-    BinarySearchTree();
-    virtual ~BinarySearchTree();
-    void InOrder();
-    void Insert(Course course);
-    void Remove(string courseNum);
-    Course Search(string courseNum);
+// Outcome of looking up a course while a load may be running
+enum LookupResult {
+    FOUND,
+    NOT_FOUND,
+    NOT_YET_LOADED
 };
 
-// Default constructor
- 
-BinarySearchTree::BinarySearchTree() {
-    root = nullptr;
+// Add a course to every index over the tree
+void indexAdd(Catalog* catalog, const Course& course) {
+    catalog->names.Add(course.courseNum, course.courseName);
+    catalog->fuzzy.Add(course.courseNum, course.courseName);
+    catalog->columns.Set(course.courseNum, course.attributes);
+    catalog->filter.Add(course.courseNum);
+    catalog->dependents.Add(course);
 }
 
-// Destructor
-BinarySearchTree::~BinarySearchTree() {
-    // recurse from root deleting every node
+// Take a course out of every index over the tree
+void indexRemove(Catalog* catalog, const string& courseNum) {
+    catalog->names.Remove(courseNum);
+    catalog->fuzzy.Remove(courseNum);
+    catalog->columns.Remove(courseNum);
+    catalog->dependents.Remove(courseNum);
 }
 
-// Traverse the tree in order
- 
-void BinarySearchTree::InOrder() {
-    // call inOrder fuction and pass root 
-    inOrder(root);
+// Add a course to the tree and every index over it
+void catalogInsert(Catalog* catalog, const Course& course) {
+    catalog->generation++;
+    {
+        CATALOG_TIME(buildNanos);
+        catalog->tree->Insert(course);
+    }
+    CATALOG_TIME(indexNanos);
+    indexAdd(catalog, course);
 }
 
+// Remove a course from the tree and every index over it
+void catalogRemove(Catalog* catalog, const string& courseNum) {
+    catalog->generation++;
+    {
+        CATALOG_TIME(buildNanos);
+        catalog->tree->Remove(courseNum);
+    }
+    CATALOG_TIME(indexNanos);
+    indexRemove(catalog, courseNum);
+}
 
+// Add courses not in the tree yet, merged into it in one pass
+void catalogInsertBatch(Catalog* catalog, const vector<Course>& courses) {
+    catalog->generation++;
+    {
+        CATALOG_TIME(buildNanos);
+        catalog->tree->InsertBatch(courses);
+    }
+    CATALOG_TIME(indexNanos);
+    for (int i = 0; i < courses.size(); i++) {
+        indexAdd(catalog, courses[i]);
+    }
+}
 
-// Insert a course
- 
-void BinarySearchTree::Insert(Course course) {
-    // if root equarl to null ptr
-    if (root == nullptr) {
-        // root is equal to new node course
-        root = new Node(course);
+// Remove courses from the tree in one pass and from every index
+void catalogRemoveBatch(Catalog* catalog, const vector<string>& courseNums) {
+    catalog->generation++;
+    {
+        CATALOG_TIME(buildNanos);
+        catalog->tree->RemoveBatch(courseNums);
     }
-    else {
-        // add Node root and course
-        this->addNode(root, course);
-    
+    CATALOG_TIME(indexNanos);
+    for (int i = 0; i < courseNums.size(); i++) {
+        indexRemove(catalog, courseNums[i]);
     }
 }
 
-// Remove a course
- 
-void BinarySearchTree::Remove(string courseNum) {
-    // remove node root course number
-    this->removeNode(root, courseNum);
+// FNV-1a hash of one CSV line
+uint64_t hashRow(const string& line) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : line) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
 }
 
-// Search for a course
- 
-Course BinarySearchTree::Search(string courseNum) {
-    // set current node equal to root
-    Node* current = root;
+// Build a course from one CSV line
+Course parseCourse(const string& line) {
+    CATALOG_TIME(parseNanos);
+    vector<string> row;
+    string word;
+    stringstream str(line);
 
-    // keep looping downwards until bottom reached or matching courseNum found
-    while (current != nullptr) {
-        // if match found, return current course
-        if (current->course.courseNum.compare(courseNum) == 0) {
-            return current->course;
-        }
-        // if course is smaller than current node then traverse left
-        if (courseNum.compare(current->course.courseNum) < 0) {
-            current = current->left;
+    while (getline(str, word, ','))
+        row.push_back(word);
+
+    Course course;
+    course.courseNum = row[0];
+    if (row.size() >= 2) {
+        course.courseName = row[1];
+    }
+    // prerequisites, then the numeric fields at the end: credits, cap, fee
+    size_t attributes = attributeStart(row, 2);
+    for (int i = 2; i < row.size(); i++) {
+        if (i >= attributes) {
+            course.attributes.push_back(row[i]);
         }
         else {
-            // else larger so traverse right
-            current = current->right;
+            course.prereqs.push_back(row[i]);
         }
     }
-
-    Course course;
     return course;
 }
 
-// Add a course to a node
-void BinarySearchTree::addNode(Node* node, Course course) {
-    // if node is larger then add to left
-    if (node->course.courseNum.compare(course.courseNum) > 0) {
-        // if no left node
-        if (node->left == nullptr) {
-            // this node becomes left
-            node->left = new Node(course);
+// Read every non-empty line of the CSV keyed by its course number
+bool readRows(const string& csvPath, unordered_map<string, string>* lines, vector<string>* order) {
+    CATALOG_TIME(parseNanos);
+    string line;
+
+    fstream file(csvPath, ios::in);
+    if (!file.is_open()) {
+        return false;
+    }
+    while (getline(file, line))
+    {
+        // tolerate files saved with windows line endings
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
         }
-        else {
-            // else recurse down the left node
-            this->addNode(node->left, course);
+        if (line.empty()) {
+            continue;
         }
+        string key = line.substr(0, line.find(','));
+        if (lines->find(key) == lines->end()) {
+            order->push_back(key);
+        }
+        (*lines)[key] = line;
+    }
+    return true;
+}
+
+// A course as the CSV line the loader would read it from, the same one
+// exportCsvRow writes
+string csvRow(const Course& course) {
+    string line = course.courseNum + "," + course.courseName;
+    for (int i = 0; i < course.prereqs.size(); i++) {
+        line += "," + course.prereqs[i];
+    }
+    for (int i = 0; i < course.attributes.size(); i++) {
+        line += "," + course.attributes[i];
+    }
+    return line;
+}
+
+// Apply one edit to the tree, the indices and the row hashes, replacing a
+// course already there. The caller holds catalog->lock.
+void catalogApply(Catalog* catalog, JournalOp op, const Course& course) {
+    if (catalog->tree->Find(course.courseNum) != nullptr) {
+        catalogRemove(catalog, course.courseNum);
+    }
+    if (op == JOURNAL_INSERT) {
+        catalogInsert(catalog, course);
+        catalog->rowHashes[course.courseNum] = hashRow(csvRow(course));
     }
     else {
-        // if no right node
-        if (node->right == nullptr) {
-            // this node becomes right
-            node->right = new Node(course);
-        }
-        else {
-            // recurse down the left node
-            this->addNode(node->right, course);
-        }
+        catalog->rowHashes.erase(course.courseNum);
     }
 }
-void BinarySearchTree::inOrder(Node* node) {
-      //if node is not equal to null ptr
-    if (node != nullptr) {
-        //InOrder left
-        inOrder(node->left);
-        //output course number, course name
-        cout << node->course.courseNum << ":  "
-            << node->course.courseName << "   "
-            << "Prerequisites: ";
-        if (node->course.prereqs.size() == 0) {
-            cout << "None" << endl;
+
+// Fold the edit log into a new snapshot of the catalog. The snapshot is
+// encoded under the read lock and written after it is released.
+bool compactCatalog(Catalog* catalog) {
+    lock_guard<mutex> one(catalog->compaction);
+    if (!catalog->journal.IsOpen()) {
+        return false;
+    }
+    string image;
+    uint64_t sequence;
+    {
+        shared_lock<shared_mutex> guard(catalog->lock);
+        sequence = catalog->journal.LastSequence();
+        image = CatalogJournal::EncodeSnapshot(*catalog->tree, sequence);
+    }
+    return catalog->journal.Compact(image, sequence);
+}
+
+// Load courses from the CSV
+//
+// Only the difference against the previous load is applied to the tree:
+// new rows are inserted, changed rows are replaced and rows that are gone
+// are removed together at the end. Unchanged rows cost a hash and a lookup.
+//
+// Runs on the loader thread. The file is read and diffed without the lock,
+// then the changes go in LOAD_BATCH at a time so the menu can answer from
+// the courses loaded so far. The result ends up in catalog->loadReport.
+//
+// A load is not written to the edit log; once it is in, the whole catalog
+// goes out as a new snapshot instead.
+void loadCourses(string csvPath, Catalog* catalog) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        auto millisSince = [](chrono::steady_clock::time_point from) {
+            return chrono::duration<double, milli>(chrono::steady_clock::now() - from).count();
+        };
+
+        // key -> line for every row in the file, last row wins on duplicates
+        unordered_map<string, string> lines;
+        vector<string> order;
+        if (!readRows(csvPath, &lines, &order)) {
+            unique_lock<shared_mutex> guard(catalog->lock);
+            catalog->reading = false;
+            catalog->loadReport = "Could not open " + csvPath;
+            return;
         }
-        else {
-            for (int i = 0; i < node->course.prereqs.size(); i++) {
-                cout << node->course.prereqs[i] << " ";
+
+        // work out what changed before touching the tree
+        unordered_map<string, uint64_t> rowHashes;
+        rowHashes.reserve(lines.size());
+        vector<string> changes;
+        int added = 0;
+        int changed = 0;
+        for (int i = 0; i < order.size(); i++) {
+            const string& key = order[i];
+            uint64_t hash;
+            {
+                CATALOG_TIME(parseNanos);
+                hash = hashRow(lines[key]);
+            }
+            rowHashes[key] = hash;
+
+            auto previous = catalog->rowHashes.find(key);
+            if (previous == catalog->rowHashes.end()) {
+                changes.push_back(key);
+                added++;
+            }
+            else if (previous->second != hash) {
+                changes.push_back(key);
+                changed++;
+            }
+        }
+
+        // collect the deletes to apply as one batch in key order at the end
+        vector<string> deletes;
+        for (auto& previous : catalog->rowHashes) {
+            if (rowHashes.find(previous.first) == rowHashes.end()) {
+                deletes.push_back(previous.first);
+            }
+        }
+        sort(deletes.begin(), deletes.end());
+
+        {
+            unique_lock<shared_mutex> guard(catalog->lock);
+            catalog->pending.insert(changes.begin(), changes.end());
+            catalog->reading = false;
+        }
+
+        double firstQuery = -1;
+        for (int i = 0; i < changes.size(); i += LOAD_BATCH) {
+            unique_lock<shared_mutex> guard(catalog->lock);
+            // changed rows come out first, then every row of the batch goes in
+            vector<string> replaced;
+            vector<Course> courses;
+            for (int j = i; j < changes.size() && j < i + LOAD_BATCH; j++) {
+                const string& key = changes[j];
+                if (catalog->rowHashes.find(key) != catalog->rowHashes.end()) {
+                    replaced.push_back(key);
+                }
+                courses.push_back(parseCourse(lines[key]));
+                catalog->pending.erase(key);
+            }
+            if (!replaced.empty()) {
+                catalogRemoveBatch(catalog, replaced);
+            }
+            catalogInsertBatch(catalog, courses);
+            if (firstQuery < 0) {
+                firstQuery = millisSince(start);
+            }
+        }
+
+        unique_lock<shared_mutex> guard(catalog->lock);
+        if (!deletes.empty()) {
+            catalogRemoveBatch(catalog, deletes);
+        }
+
+        // a first load from a sorted file leaves a list, relink it once
+        if (catalog->rowHashes.empty()) {
+            catalog->tree->Rebalance();
+        }
+        catalog->rowHashes.swap(rowHashes);
+
+        // check the prerequisites once the catalog is serving again
+        PrereqGraph graph;
+        graph.Build(*catalog->tree);
+        vector<string> keys;
+        keys.reserve(catalog->rowHashes.size());
+        for (auto& row : catalog->rowHashes) {
+            keys.push_back(row.first);
+        }
+        guard.unlock();
+
+        // a fresh filter of exactly this file's courses, so removed ones drop out;
+        // until it is swapped in the old one still passes every loaded course
+        BloomFilter filter;
+        filter.Reset(keys.size());
+        for (int i = 0; i < keys.size(); i++) {
+            filter.Add(keys[i]);
+        }
+        guard.lock();
+        catalog->filter = move(filter);
+        guard.unlock();
+
+        auto validateStart = chrono::steady_clock::now();
+        PrereqReport prereqs = graph.Validate();
+        double validateMillis = millisSince(validateStart);
+
+        auto snapshotStart = chrono::steady_clock::now();
+        bool snapshot = compactCatalog(catalog);
+        double snapshotMillis = millisSince(snapshotStart);
+
+        if (firstQuery < 0) {
+            firstQuery = millisSince(start);
+        }
+        stringstream report;
+        report << "Courses loaded: " << added << " added, " << changed << " changed, "
+            << deletes.size() << " removed in " << millisSince(start) << " ms, first courses answerable after "
+            << firstQuery << " ms.";
+        report << endl << "Prerequisites checked in " << validateMillis << " ms: " << prereqs.layers << " levels, "
+            << prereqs.cycles.size() << " cycles, " << prereqs.missing.size() << " missing.";
+        if (snapshot) {
+            report << endl << "Snapshot written in " << snapshotMillis << " ms.";
+        }
+        for (int i = 0; i < prereqs.cycles.size() && i < 5; i++) {
+            report << endl << "Warning: prerequisite cycle";
+            for (int j = 0; j < prereqs.cycles[i].size(); j++) {
+                report << " " << prereqs.cycles[i][j];
             }
-            cout << endl;
         }
-        //InOrder right
-        inOrder(node->right);
-      }
+        for (int i = 0; i < prereqs.missing.size() && i < 5; i++) {
+            report << endl << "Warning: " << prereqs.missing[i].first << " requires unknown course "
+                << prereqs.missing[i].second;
+        }
+        guard.lock();
+        catalog->loadReport = report.str();
 }
 
-Node* BinarySearchTree::removeNode(Node* node, string courseNum) {
-    // If node is null then tree is empty, so return
-    if (node == nullptr) {
-        return nullptr;
+// Start loading on the background thread unless a load is already running
+void startLoading(string csvPath, Catalog* catalog) {
+    if (catalog->loading) {
+        cout << "Courses are still loading." << endl;
+        return;
     }
-    // if node is to the left, traverse down left side
-    if (courseNum.compare(node->course.courseNum) < 0) {
-        node->left = removeNode(node->left, courseNum);
+    if (catalog->loader.joinable()) {
+        catalog->loader.join();
     }
-    // if node is to the right, traverse down right side
-    else if (courseNum.compare(node->course.courseNum) >0) {
-        node->right = removeNode(node->right, courseNum);
+    cout << "Loading courses... " << endl;
+    {
+        unique_lock<shared_mutex> guard(catalog->lock);
+        catalog->reading = true;
     }
-    else {
-        // if no children just delete node
-        if (node->left == nullptr && node->right == nullptr) {
-            delete node;
-            node = nullptr;
-        }
-        // if child to the left
-        else if (node->left != nullptr && node->right == nullptr) {
-            Node* temp = node;
-            node = node->left;
-            delete temp;
-        }
-        // if child to the right
-        else if (node->left == nullptr && node->right != nullptr) {
-            Node* temp = node;
-            node = node->right;
-            delete temp;
-        }
-        // two children
-        else {
-            Node* temp = node->right;
-            while (temp->left != nullptr) {
-                temp = temp->left;
-            }
-            node->course = temp->course;
-            node->right = removeNode(node->right, temp->course.courseNum);
-        }
+    catalog->loading = true;
+    catalog->loader = thread([csvPath, catalog]() {
+        loadCourses(csvPath, catalog);
+        catalog->loading = false;
+    });
+}
+
+// Compact on the background thread once the edit log has grown enough
+void startCompaction(Catalog* catalog) {
+    if (catalog->journal.LogBytes() < COMPACT_LOG_BYTES || catalog->compacting.exchange(true)) {
+        return;
+    }
+    if (catalog->compactor.joinable()) {
+        catalog->compactor.join();
     }
+    catalog->compactor = thread([catalog]() {
+        compactCatalog(catalog);
+        catalog->compacting = false;
+    });
 }
 
+// Apply an edit made in the menu and log it, true once it is on disk.
+// Edits logged together by several callers share one flush.
+bool catalogEdit(Catalog* catalog, JournalOp op, const Course& course) {
+    uint64_t sequence;
+    {
+        unique_lock<shared_mutex> guard(catalog->lock);
+        catalogApply(catalog, op, course);
+        sequence = catalog->journal.Append(op, course);
+    }
+    // wait for the disk without holding up readers
+    bool durable = catalog->journal.IsOpen() && catalog->journal.Sync(sequence);
+    startCompaction(catalog);
+    return durable;
+}
 
+// insert sorted[lo, hi) middle first, so a plain tree comes out balanced
+void insertBalanced(Catalog* catalog, const vector<Course>& sorted, size_t lo, size_t hi) {
+    if (lo >= hi) {
+        return;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    catalogInsert(catalog, sorted[mid]);
+    catalog->rowHashes[sorted[mid].courseNum] = hashRow(csvRow(sorted[mid]));
+    insertBalanced(catalog, sorted, lo, mid);
+    insertBalanced(catalog, sorted, mid + 1, hi);
+}
 
-// Display course information
+// Restore the catalog from the snapshot and edit log next to the CSV and
+// start logging edits, on an empty catalog at startup. Returns how many
+// courses came back.
+//
+// Only the last edit of each course matters, so the edits are merged into
+// the snapshot's key order and everything goes in middle first.
+size_t openJournal(const string& csvPath, Catalog* catalog) {
+    auto start = chrono::steady_clock::now();
+    unique_lock<shared_mutex> guard(catalog->lock);
+    vector<Course> snapshot;
+    map<string, pair<JournalOp, Course>> edits;
+    JournalRecovery recovery;
+    bool opened = catalog->journal.Open(csvPath, [&](const Course& course) {
+        snapshot.push_back(course);
+    }, [&](JournalOp op, const Course& course) {
+        edits[course.courseNum] = make_pair(op, course);
+    }, &recovery);
 
-void displayCourse(Course course) {
-    cout << course.courseNum << ": " << course.courseName << "  " << endl;
-    cout << "Prerequisites: ";
-    if (course.prereqs.size() == 0) {
-        cout << "No prerequisites" << endl;
-    }
-    else {
-        for (int i = 0; i < course.prereqs.size(); i++) {
-            cout << course.prereqs[i] << " ";
+    vector<Course> courses;
+    courses.reserve(snapshot.size() + edits.size());
+    size_t next = 0;
+    for (auto& edit : edits) {
+        // snapshot courses before the edited one stay as they are
+        while (next < snapshot.size() && snapshot[next].courseNum < edit.first) {
+            courses.push_back(snapshot[next++]);
+        }
+        // the edit replaces or removes the snapshot's course
+        if (next < snapshot.size() && snapshot[next].courseNum == edit.first) {
+            next++;
+        }
+        if (edit.second.first == JOURNAL_INSERT) {
+            courses.push_back(edit.second.second);
         }
-        cout << endl;
     }
-    return;
-}
+    while (next < snapshot.size()) {
+        courses.push_back(snapshot[next++]);
+    }
+    insertBalanced(catalog, courses, 0, courses.size());
 
-// Load courses from the CSV
-void loadCourses(string csvPath, BinarySearchTree* bst) {
+    // every restored course, so unknown numbers are turned away again
+    BloomFilter filter;
+    filter.Reset(catalog->rowHashes.size());
+    for (auto& row : catalog->rowHashes) {
+        filter.Add(row.first);
+    }
+    catalog->filter = move(filter);
+    guard.unlock();
 
-        cout << "Loading courses... " << endl;
+    double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (recovery.snapshotCourses > 0 || recovery.replayed > 0) {
+        cout << "Restored " << recovery.snapshotCourses << " courses from " << csvPath << ".snap and "
+            << recovery.replayed << " edits from " << csvPath << ".log in " << millis << " ms." << endl;
+    }
+    if (recovery.snapshotCorrupt) {
+        cout << "Warning: " << csvPath << ".snap is damaged and was skipped." << endl;
+    }
+    if (recovery.droppedBytes > 0) {
+        cout << "Warning: cut " << recovery.droppedBytes << " damaged bytes off the end of " << csvPath << ".log." << endl;
+    }
+    if (!opened) {
+        cout << "Could not open " << csvPath << ".log, edits will not be saved." << endl;
+    }
+    return catalog->tree->Size();
+}
 
-        string fname = "ABCU_Advising_Program_Input.csv";
-        vector<vector<string>> content;
-        vector<string> row;
-        string line, word;
+// Display text of a course, from the cache when it is still current.
+// The caller holds catalog->lock, so the generation cannot move meanwhile.
+bool cachedDisplay(Catalog* catalog, const string& courseNum, string* text) {
+    if (!catalog->filter.MayContain(courseNum)) {
+        CATALOG_METRIC(filterRejects, 1);
+        return false;
+    }
+    if (catalog->display.Get(courseNum, catalog->generation, text)) {
+        return true;
+    }
+    const Course* found = catalog->tree->Find(courseNum);
+    if (found == nullptr) {
+        return false;
+    }
+    *text = formatCourse(*found);
+    catalog->display.Put(courseNum, catalog->generation, *text);
+    return true;
+}
 
-        fstream file(fname, ios::in);
-        if (file.is_open())
-        {
-            while (getline(file, line))
-            {
-                row.clear();
+// Look up a course for display, telling a missing course from one that is still loading
+LookupResult catalogFind(Catalog* catalog, const string& courseNum, string* text) {
+    shared_lock<shared_mutex> guard(catalog->lock);
+    if (cachedDisplay(catalog, courseNum, text)) {
+        return FOUND;
+    }
+    if (catalog->reading || catalog->pending.find(courseNum) != catalog->pending.end()) {
+        return NOT_YET_LOADED;
+    }
+    return NOT_FOUND;
+}
 
-                stringstream str(line);
+// Courses plus every prerequisite they need, directly or not, each once.
+// Course numbers not in the catalog go to missing. The caller holds catalog->lock.
+vector<string> prereqClosure(Catalog* catalog, const vector<string>& courses, vector<string>* missing) {
+    vector<string> closure;
+    vector<string> stack(courses.rbegin(), courses.rend());
+    unordered_set<string> seen;
+    while (!stack.empty()) {
+        string key = stack.back();
+        stack.pop_back();
+        if (!seen.insert(key).second) {
+            continue;
+        }
+        const Course* found = catalog->tree->Find(key);
+        if (found == nullptr) {
+            missing->push_back(key);
+            continue;
+        }
+        closure.push_back(key);
+        for (int i = 0; i < found->prereqs.size(); i++) {
+            stack.push_back(found->prereqs[i]);
+        }
+    }
+    return closure;
+}
 
-                while (getline(str, word, ','))
-                    row.push_back(word);
-                content.push_back(row);
+// Answer a batch of socket requests under one read lock
+void serveBatch(Catalog* catalog, const vector<CatalogRequest>& requests, vector<CatalogResponse>& responses) {
+    shared_lock<shared_mutex> guard(catalog->lock);
+    for (int i = 0; i < requests.size(); i++) {
+        const CatalogRequest& request = requests[i];
+        CatalogResponse& response = responses[i];
+        response.status = STATUS_OK;
+        switch (request.op) {
+        case OP_LOOKUP:
+            if (!cachedDisplay(catalog, request.key, &response.body)) {
+                response.status = STATUS_NOT_FOUND;
             }
+            break;
+        case OP_RANGE:
+            catalog->tree->Range(request.key, request.high, [&](const Course& course) {
+                response.body += course.courseNum;
+                response.body += '\n';
+            });
+            break;
+        case OP_DEPENDENTS: {
+            if (catalog->tree->Find(request.key) == nullptr) {
+                response.status = STATUS_NOT_FOUND;
+                break;
+            }
+            vector<string> dependents = catalog->dependents.Transitive(request.key);
+            for (int j = 0; j < dependents.size(); j++) {
+                response.body += dependents[j];
+                response.body += '\n';
+            }
+            break;
         }
-
-        for (int i = 0; i < content.size(); i++) {
-            Course course;
-            course.courseNum = content[i][0];
-            course.courseName = content[i][1];
-            if (content[i].size() >= 3) {
-                course.prereqs.push_back(content[i][2]);
-                if (content[i].size() == 4) {
-                    course.prereqs.push_back(content[i][3]);
-                }
+        case OP_PREREQS: {
+            vector<string> missing;
+            vector<string> closure = prereqClosure(catalog, vector<string>(1, request.key), &missing);
+            if (closure.empty()) {
+                response.status = STATUS_NOT_FOUND;
             }
+            // the first one is the course itself
+            for (int j = 1; j < closure.size(); j++) {
+                response.body += closure[j];
+                response.body += '\n';
+            }
+            break;
+        }
+        default:
+            response.status = STATUS_BAD_REQUEST;
+        }
+    }
+}
+
+#ifdef __linux__
+CatalogServer* runningServer = nullptr;
 
-            // push this course to the end
-            bst->Insert(course);
-        } 
+void stopServer(int) {
+    if (runningServer != nullptr) {
+        runningServer->Stop();
+    }
+}
+#endif
+
+// Load the catalog once and answer queries on a Unix socket until interrupted
+int serve(const string& socketPath, const string& csvPath, CatalogTree* tree) {
+#ifdef __linux__
+    Catalog catalog;
+    catalog.tree = tree;
+    // the restored courses and their row hashes make the load a diff
+    // against the CSV, so a CSV edited while the server was down is served
+    openJournal(csvPath, &catalog);
+    loadCourses(csvPath, &catalog);
+    cout << catalog.loadReport << endl;
+
+    CatalogServer server([&catalog](const vector<CatalogRequest>& requests, vector<CatalogResponse>& responses) {
+        serveBatch(&catalog, requests, responses);
+    });
+    if (!server.Listen(socketPath)) {
+        cout << "Could not listen on " << socketPath << "." << endl;
+        return 1;
+    }
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cout << "Serving " << tree->Size() << " " << tree->Name() << " courses on " << socketPath << ", Ctrl-C stops." << endl;
+    server.Run();
+    runningServer = nullptr;
+    cout << "Good bye." << endl;
+    return 0;
+#else
+    cout << "Server mode needs Linux." << endl;
+    return 1;
+#endif
 }
 
 /**
@@ -300,8 +743,26 @@ double strToDouble(string str, char ch) {
 
 int main(int argc, char* argv[]) {
 
-    // process command line arguments
-    string csvPath, courseKey;
+    // process command line arguments, --tree bst, art or multi may come first
+    string csvPath, courseKey, treeName = "bst";
+    if (argc >= 3 && string(argv[1]) == "--tree") {
+        treeName = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    // Define a tree to hold all courses
+    CatalogTree* bst = makeCatalogTree(treeName);
+    if (bst == nullptr) {
+        cout << "Unknown tree " << treeName << ", use bst, art or multi." << endl;
+        return 1;
+    }
+
+    if (argc >= 3 && string(argv[1]) == "--serve") {
+        int status = serve(argv[2], argc >= 4 ? argv[3] : "ABCU_Advising_Program_Input.csv", bst);
+        delete bst;
+        return status;
+    }
     switch (argc) {
     case 2:
         csvPath = argv[1];
@@ -316,18 +777,34 @@ int main(int argc, char* argv[]) {
     }
 
 
-    // Define a binary search tree to hold all courses
-    BinarySearchTree* bst;
-    bst = new BinarySearchTree();
-    Course course;
+    Catalog catalog;
+    catalog.tree = bst;
+    openJournal(csvPath, &catalog);
 
     int choice = 0;
     while (choice != 9) {
+        {
+            // say when a background load has finished
+            unique_lock<shared_mutex> guard(catalog.lock);
+            if (!catalog.loadReport.empty()) {
+                cout << catalog.loadReport << endl;
+                catalog.loadReport.clear();
+            }
+        }
         cout << "Menu:" << endl;
         cout << "  1. Load Courses" << endl;
         cout << "  2. Display All Courses" << endl;
         cout << "  3. Find Course" << endl;
+        cout << "  4. Search Course Names" << endl;
+        cout << "  5. Show Metrics" << endl;
+        cout << "  6. Export Courses" << endl;
+        cout << "  7. Degree Plan Totals" << endl;
+        cout << "  8. Find Courses by Credits" << endl;
         cout << "  9. Exit" << endl;
+        cout << " 10. Add or Replace Course" << endl;
+        cout << " 11. Remove Course" << endl;
+        cout << " 12. Find Dependent Courses" << endl;
+        cout << " 13. List Courses by Name" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
@@ -335,29 +812,272 @@ int main(int argc, char* argv[]) {
 
         case 1:
             // Complete the method call to load the courses
-            loadCourses(csvPath, bst);
+            startLoading(csvPath, &catalog);
 
             break;
 
-        case 2:
+        case 2: {
+            shared_lock<shared_mutex> guard(catalog.lock);
             bst->InOrder();
+            if (catalog.loading) {
+                cout << "(still loading, " << catalog.pending.size() << " more to come)" << endl;
+            }
             break;
+        }
 
-        case 3:
+        case 3: {
             cout << "Enter course number for the course: " << endl;
             cin >> courseKey;
-            course = bst->Search(courseKey);
+            string text;
+            LookupResult result = catalogFind(&catalog, courseKey, &text);
 
-            if (!course.courseNum.empty()) {
-                displayCourse(course);
+            if (result == FOUND) {
+                cout << text;
+            } else if (result == NOT_YET_LOADED) {
+                cout << "Course number " << courseKey << " is not loaded yet, try again shortly." << endl;
             } else {
             	cout << "Course number " << courseKey << " not found." << endl;
+
+                // suggest close matches, ignoring ones that share almost nothing
+                shared_lock<shared_mutex> guard(catalog.lock);
+                vector<FuzzyMatch> matches = catalog.fuzzy.Search(courseKey, 3);
+                int limit = max(2, (int)courseKey.size() / 3);
+                bool first = true;
+                for (int i = 0; i < matches.size(); i++) {
+                    if (matches[i].distance > limit) {
+                        continue;
+                    }
+                    if (first) {
+                        cout << "Did you mean:" << endl;
+                        first = false;
+                    }
+                    cout << "  " << matches[i].courseNum << endl;
+                }
             }
 
             break;
+        }
+
+        case 4: {
+            cout << "Enter words to search for: " << endl;
+            string query;
+            getline(cin >> ws, query);
+            shared_lock<shared_mutex> guard(catalog.lock);
+            vector<string> matches = catalog.names.Search(query);
+            sort(matches.begin(), matches.end());
 
+            string text;
+            for (int i = 0; i < matches.size(); i++) {
+                if (cachedDisplay(&catalog, matches[i], &text)) {
+                    cout << text;
+                }
+            }
+            cout << matches.size() << " course(s) match \"" << query << "\"." << endl;
+
+            break;
         }
+
+        case 5: {
+            shared_lock<shared_mutex> guard(catalog.lock);
+            TreeShape shape = bst->Shape();
+            cout << "Courses: " << shape.nodes << ", " << bst->Name() << " depth " << shape.maxDepth
+                << " max, " << shape.averageDepth << " average" << endl;
+            dumpMetrics(cout);
+            break;
+        }
+
+        case 6: {
+            cout << "Enter format (csv, json or ndjson) and file name: " << endl;
+            string format, exportPath;
+            cin >> format >> exportPath;
+            ExportFormat exportFormat = EXPORT_CSV;
+            if (format == "json") {
+                exportFormat = EXPORT_JSON;
+            } else if (format == "ndjson") {
+                exportFormat = EXPORT_NDJSON;
+            } else if (format != "csv") {
+                cout << "Unknown format " << format << "." << endl;
+                break;
+            }
+
+            shared_lock<shared_mutex> guard(catalog.lock);
+            auto exportStart = chrono::steady_clock::now();
+            uint64_t bytes = 0;
+            if (exportCatalog(*bst, exportFormat, exportPath, &bytes)) {
+                double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - exportStart).count();
+                cout << bst->Size() << " courses, " << bytes << " bytes written to " << exportPath
+                    << " in " << millis << " ms." << endl;
+            } else {
+                cout << "Could not write " << exportPath << "." << endl;
+            }
+            break;
+        }
+
+        case 7: {
+            cout << "Enter the course numbers of the plan: " << endl;
+            string line, planKey;
+            getline(cin >> ws, line);
+            stringstream planKeys(line);
+
+            // the plan includes every prerequisite of its courses
+            vector<string> planCourses, missing;
+            while (planKeys >> planKey) {
+                planCourses.push_back(planKey);
+            }
+            shared_lock<shared_mutex> guard(catalog.lock);
+            planCourses = prereqClosure(&catalog, planCourses, &missing);
+            for (int i = 0; i < missing.size(); i++) {
+                cout << "Course number " << missing[i] << " not found." << endl;
+            }
+            vector<uint32_t> plan;
+            for (int i = 0; i < planCourses.size(); i++) {
+                plan.push_back(catalog.columns.IdOf(planCourses[i]));
+            }
+            cout << plan.size() << " courses with prerequisites, " << catalog.columns.Sum(CREDITS, plan)
+                << " credits, $" << catalog.columns.Sum(FEE, plan) << " in fees." << endl;
+
+            const char* names[COLUMN_COUNT] = { "Credits", "Cap", "Fee" };
+            for (int c = 0; c < COLUMN_COUNT; c++) {
+                ColumnSummary summary = catalog.columns.Summarize((CourseColumn)c);
+                if (summary.count > 0) {
+                    cout << names[c] << " across the catalog: " << summary.count << " courses, total " << summary.sum
+                        << ", min " << summary.min << ", max " << summary.max << endl;
+                }
+            }
+            break;
+        }
+
+        case 8: {
+            cout << "Enter the least and most credits: " << endl;
+            double least = 0, most = 0;
+            cin >> least >> most;
+            shared_lock<shared_mutex> guard(catalog.lock);
+            vector<uint32_t> ids = catalog.columns.Filter(CREDITS, least, most);
+            vector<string> matches;
+            for (int i = 0; i < ids.size(); i++) {
+                matches.push_back(catalog.columns.KeyOf(ids[i]));
+            }
+            sort(matches.begin(), matches.end());
+
+            string text;
+            for (int i = 0; i < matches.size(); i++) {
+                if (cachedDisplay(&catalog, matches[i], &text)) {
+                    cout << text;
+                }
+            }
+            cout << matches.size() << " course(s) with " << least << " to " << most << " credits." << endl;
+            break;
+        }
+
+        case 10: {
+            cout << "Enter the course as a CSV line (number,name,prerequisites...,credits,cap,fee): " << endl;
+            string line;
+            getline(cin >> ws, line);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (catalog.loading) {
+                cout << "Courses are still loading, try again shortly." << endl;
+                break;
+            }
+            Course course = parseCourse(line);
+            if (course.courseNum.empty()) {
+                cout << "A course needs a course number." << endl;
+                break;
+            }
+            if (catalogEdit(&catalog, JOURNAL_INSERT, course)) {
+                cout << "Course " << course.courseNum << " saved." << endl;
+            } else {
+                cout << "Course " << course.courseNum << " changed, but the edit log could not be written." << endl;
+            }
+            break;
+        }
+
+        case 11: {
+            cout << "Enter course number to remove: " << endl;
+            cin >> courseKey;
+            if (catalog.loading) {
+                cout << "Courses are still loading, try again shortly." << endl;
+                break;
+            }
+            bool found;
+            {
+                shared_lock<shared_mutex> guard(catalog.lock);
+                found = bst->Find(courseKey) != nullptr;
+            }
+            if (!found) {
+                cout << "Course number " << courseKey << " not found." << endl;
+                break;
+            }
+            Course course;
+            course.courseNum = courseKey;
+            if (catalogEdit(&catalog, JOURNAL_REMOVE, course)) {
+                cout << "Course " << courseKey << " removed." << endl;
+            } else {
+                cout << "Course " << courseKey << " removed, but the edit log could not be written." << endl;
+            }
+            break;
+        }
+
+        case 12: {
+            cout << "Enter course number to find the courses that need it: " << endl;
+            cin >> courseKey;
+            shared_lock<shared_mutex> guard(catalog.lock);
+            if (bst->Find(courseKey) == nullptr) {
+                cout << "Course number " << courseKey << " not found." << endl;
+                break;
+            }
+            auto queryStart = chrono::steady_clock::now();
+            vector<string> direct = catalog.dependents.Direct(courseKey);
+            vector<string> all = catalog.dependents.Transitive(courseKey);
+            double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - queryStart).count();
+            sort(direct.begin(), direct.end());
+            sort(all.begin(), all.end());
+
+            cout << "Directly required by: ";
+            for (int i = 0; i < direct.size(); i++) {
+                cout << direct[i] << " ";
+            }
+            cout << endl << "Required directly or not by " << all.size() << " course(s): ";
+            for (int i = 0; i < all.size(); i++) {
+                cout << all[i] << " ";
+            }
+            cout << endl << "Found in " << micros << " us." << endl;
+            break;
+        }
+
+        case 13: {
+            cout << "Enter a department, or all for every course: " << endl;
+            string department;
+            cin >> department;
+            shared_lock<shared_mutex> guard(catalog.lock);
+            auto listStart = chrono::steady_clock::now();
+            int listed = 0;
+            auto show = [&listed](const Course& course) {
+                displayRow(course);
+                listed++;
+            };
+            if (department == "all") {
+                bst->ByName(show);
+            } else {
+                bst->InDepartment(department, show);
+            }
+            double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - listStart).count();
+            cout << listed << " course(s) listed by name in " << millis << " ms." << endl;
+            break;
+        }
+
+        }
+    }
+
+    // let a running load and compaction finish before the tree goes away
+    if (catalog.loader.joinable()) {
+        catalog.loader.join();
+    }
+    if (catalog.compactor.joinable()) {
+        catalog.compactor.join();
     }
+    delete bst;
 
     cout << "Good bye." << endl;
 
@@ -0,0 +1,887 @@
+//============================================================================
+// Name        : BinarySearchTree.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef BINARY_SEARCH_TREE_HPP
+#define BINARY_SEARCH_TREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "CatalogMetrics.hpp"
+
+// Shape of a tree, computed on demand
+struct TreeShape {
+    size_t nodes;
+    size_t maxDepth;
+    double averageDepth;
+};
+
+// Tree modes
+struct PlainTree {
+};
+
+// Every Find, Insert and Remove splays the key to the root, so keys that
+// are looked up often stay near the top. A splay tree changes shape on
+// lookups, so it must not be searched from several threads at once.
+struct SplayTree {
+};
+
+// Binary search tree over values of type Value ordered by a key
+//
+// KeyOf pulls the key out of a value and Compare orders two keys. Both are
+// stateless function objects built at the call site, so the compiler sees
+// through them and inlines every comparison. Equal keys go to the right,
+// the same as the original course tree.
+template <typename Key, typename Value, typename KeyOf, typename Compare = std::less<Key>, typename Mode = PlainTree>
+class SearchTree {
+
+public:
+    // Internal structure for tree node
+    struct Node {
+        Value value;
+        Node* left;
+        Node* right;
+
+        // initialize with a value
+        Node(const Value& aValue) : value(aValue) {
+            left = nullptr;
+            right = nullptr;
+        }
+    };
+
+private:
+    static const bool splays = std::is_same<Mode, SplayTree>::value;
+    // below this many batch entries a subtree is merged on the calling thread
+    static const size_t PARALLEL_BATCH = 4096;
+    // a batch this small relinks a subtree only past the depth of a balanced tree
+    static const size_t DENSE_BATCH = 8;
+
+    // mutable because a splay tree reshapes itself on lookups
+    mutable Node* root;
+    // Split and Join do not know the sizes of the halves, count is
+    // recomputed on the next Size() call when counted is false
+    mutable size_t count;
+    mutable bool counted;
+
+    static decltype(auto) keyOf(const Value& value) {
+        return KeyOf()(value);
+    }
+
+    static bool less(const Key& a, const Key& b) {
+        return Compare()(a, b);
+    }
+
+    // Top-down splay: bring the node with key, or the last node on its
+    // search path, to the root. Nodes passed on the way down are hung on a
+    // left tree (smaller keys) and a right tree (larger keys) that become
+    // the children of the new root. Returns the number of comparisons.
+    size_t splay(const Key& key) const {
+        if (root == nullptr) {
+            return 0;
+        }
+        size_t compares = 0;
+        Node* leftTree = nullptr;
+        Node* rightTree = nullptr;
+        Node** leftHook = &leftTree;
+        Node** rightHook = &rightTree;
+        Node* node = root;
+        while (true) {
+            compares++;
+            if (less(key, keyOf(node->value))) {
+                if (node->left == nullptr) {
+                    break;
+                }
+                compares++;
+                if (less(key, keyOf(node->left->value))) {
+                    // zig-zig, rotate right first
+                    Node* child = node->left;
+                    node->left = child->right;
+                    child->right = node;
+                    node = child;
+                    if (node->left == nullptr) {
+                        break;
+                    }
+                }
+                // node and its right side are all larger than key
+                *rightHook = node;
+                rightHook = &node->left;
+                node = node->left;
+                continue;
+            }
+            compares++;
+            if (less(keyOf(node->value), key)) {
+                if (node->right == nullptr) {
+                    break;
+                }
+                compares++;
+                if (less(keyOf(node->right->value), key)) {
+                    // zag-zag, rotate left first
+                    Node* child = node->right;
+                    node->right = child->left;
+                    child->left = node;
+                    node = child;
+                    if (node->right == nullptr) {
+                        break;
+                    }
+                }
+                // node and its left side are all smaller than key
+                *leftHook = node;
+                leftHook = &node->right;
+                node = node->right;
+                continue;
+            }
+            break;
+        }
+        *leftHook = node->left;
+        *rightHook = node->right;
+        node->left = leftTree;
+        node->right = rightTree;
+        root = node;
+        return compares;
+    }
+
+    // every node in key order
+    void flatten(std::vector<Node*>& nodes) const {
+        nodes.reserve(nodes.size() + Size());
+        collect(root, nodes);
+    }
+
+    // every node of a subtree in key order
+    static void collect(Node* node, std::vector<Node*>& nodes) {
+        std::vector<Node*> stack;
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                stack.push_back(node);
+                node = node->left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            nodes.push_back(node);
+            node = node->right;
+        }
+    }
+
+    // link nodes[lo, hi) into a perfectly balanced subtree
+    static Node* build(std::vector<Node*>& nodes, size_t lo, size_t hi) {
+        if (lo >= hi) {
+            return nullptr;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        Node* node = nodes[mid];
+        node->left = build(nodes, lo, mid);
+        node->right = build(nodes, mid + 1, hi);
+        return node;
+    }
+
+    // whether k batch entries are worth relinking a subtree of about estimate nodes
+    static bool dense(size_t k, size_t estimate) {
+        return 4 * k >= estimate && (k >= DENSE_BATCH || estimate == 0);
+    }
+
+    // levels of a perfectly balanced tree of n nodes
+    static size_t balancedHeight(size_t n) {
+        size_t height = 0;
+        for (; n > 0; n >>= 1) {
+            height++;
+        }
+        return height;
+    }
+
+    // run left() on a new thread and right() on this one when the batch is
+    // big enough and threads are left, splitting the rest between the two
+    template <typename Left, typename Right>
+    static void both(size_t batch, unsigned spawn, Left left, Right right) {
+        if (spawn == 0 || batch < PARALLEL_BATCH) {
+            // one after the other, so each may use every thread left
+            left(spawn);
+            right(spawn);
+            return;
+        }
+        unsigned leftSpawn = (spawn - 1) / 2;
+        std::thread worker(left, leftSpawn);
+        right(spawn - 1 - leftSpawn);
+        worker.join();
+    }
+
+    // Merge the new nodes fresh[0, k), in key order, into the subtree at node
+    //
+    // The subtree sits depth levels down and holds about estimate nodes if
+    // the tree is balanced. Where the batch is sparse it is split at each
+    // node and both halves go down their own side, in parallel near the
+    // top; at an empty link, or once the batch is a quarter of the subtree,
+    // the old nodes and the new ones are relinked balanced. Past the depth
+    // of a balanced tree the estimate is 0 and any batch relinks, so a
+    // degenerate tree is not walked down one level at a time. deepest gets
+    // the deepest level a new node ends up on.
+    static Node* insertSorted(Node* node, Node* const* fresh, size_t k, size_t depth, size_t estimate,
+        unsigned spawn, size_t& deepest) {
+        deepest = depth;
+        if (k == 0) {
+            return node;
+        }
+        if (node == nullptr && k == 1) {
+            return fresh[0];
+        }
+        if (node == nullptr || dense(k, estimate)) {
+            std::vector<Node*> nodes;
+            collect(node, nodes);
+            std::vector<Node*> merged;
+            merged.reserve(nodes.size() + k);
+            size_t i = 0;
+            for (size_t j = 0; j < k; j++) {
+                // equal keys go after the ones already there, as Insert puts them
+                while (i < nodes.size() && !less(keyOf(fresh[j]->value), keyOf(nodes[i]->value))) {
+                    merged.push_back(nodes[i++]);
+                }
+                merged.push_back(fresh[j]);
+            }
+            merged.insert(merged.end(), nodes.begin() + i, nodes.end());
+            deepest = depth + balancedHeight(merged.size());
+            return build(merged, 0, merged.size());
+        }
+        // nodes below this one's key go left, the rest right
+        Node* const* split = std::partition_point(fresh, fresh + k, [node](const Node* next) {
+            return less(keyOf(next->value), keyOf(node->value));
+        });
+        size_t below = (size_t)(split - fresh);
+        size_t leftDeepest = 0;
+        size_t rightDeepest = 0;
+        both(std::min(below, k - below), spawn, [&](unsigned more) {
+            node->left = insertSorted(node->left, fresh, below, depth + 1, estimate / 2, more, leftDeepest);
+        }, [&](unsigned more) {
+            node->right = insertSorted(node->right, split, k - below, depth + 1, estimate / 2, more, rightDeepest);
+        });
+        deepest = std::max(leftDeepest, rightDeepest);
+        return node;
+    }
+
+    // Remove every value whose key is in keys[0, k), sorted and distinct,
+    // from the subtree at node; the same split as insertSorted
+    static Node* removeSorted(Node* node, const Key* keys, size_t k, size_t estimate, unsigned spawn,
+        size_t& removed) {
+        removed = 0;
+        if (node == nullptr || k == 0) {
+            return node;
+        }
+        if (dense(k, estimate)) {
+            std::vector<Node*> nodes;
+            collect(node, nodes);
+            size_t kept = 0;
+            size_t j = 0;
+            for (size_t i = 0; i < nodes.size(); i++) {
+                const Key& key = keyOf(nodes[i]->value);
+                while (j < k && less(keys[j], key)) {
+                    j++;
+                }
+                if (j < k && !less(key, keys[j])) {
+                    delete nodes[i];
+                    removed++;
+                }
+                else {
+                    nodes[kept++] = nodes[i];
+                }
+            }
+            return build(nodes, 0, kept);
+        }
+        // a key equal to this node's may also sit on either side of it
+        const Key* lower = std::lower_bound(keys, keys + k, keyOf(node->value), [](const Key& a, const Key& b) {
+            return less(a, b);
+        });
+        size_t below = (size_t)(lower - keys);
+        bool hit = below < k && !less(keyOf(node->value), *lower);
+        size_t leftRemoved = 0;
+        size_t rightRemoved = 0;
+        both(std::min(below, k - below), spawn, [&](unsigned more) {
+            node->left = removeSorted(node->left, keys, below + (hit ? 1 : 0), estimate / 2, more, leftRemoved);
+        }, [&](unsigned more) {
+            node->right = removeSorted(node->right, lower, k - below, estimate / 2, more, rightRemoved);
+        });
+        removed = leftRemoved + rightRemoved;
+        if (!hit) {
+            return node;
+        }
+        // the smallest node on the right takes this one's place
+        Node* left = node->left;
+        Node* right = node->right;
+        delete node;
+        removed++;
+        if (left == nullptr || right == nullptr) {
+            return left != nullptr ? left : right;
+        }
+        Node* parent = nullptr;
+        Node* next = right;
+        while (next->left != nullptr) {
+            parent = next;
+            next = next->left;
+        }
+        if (parent != nullptr) {
+            parent->left = next->right;
+            next->right = right;
+        }
+        next->left = left;
+        return next;
+    }
+
+public:
+    SearchTree() {
+        root = nullptr;
+        count = 0;
+        counted = true;
+    }
+
+    // trees own their nodes, so they move but do not copy
+    SearchTree(const SearchTree&) = delete;
+    SearchTree& operator=(const SearchTree&) = delete;
+
+    SearchTree(SearchTree&& other) {
+        root = other.root;
+        count = other.count;
+        counted = other.counted;
+        other.root = nullptr;
+        other.count = 0;
+        other.counted = true;
+    }
+
+    SearchTree& operator=(SearchTree&& other) {
+        if (this != &other) {
+            Clear();
+            root = other.root;
+            count = other.count;
+            counted = other.counted;
+            other.root = nullptr;
+            other.count = 0;
+            other.counted = true;
+        }
+        return *this;
+    }
+
+    ~SearchTree() {
+        Clear();
+    }
+
+    // Delete every node
+    void Clear() {
+        // unhook left children into the right spine so no stack is needed
+        Node* node = root;
+        while (node != nullptr) {
+            if (node->left != nullptr) {
+                Node* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            }
+            else {
+                Node* next = node->right;
+                delete node;
+                CATALOG_METRIC(bytesFreed, sizeof(Node));
+                node = next;
+            }
+        }
+        root = nullptr;
+        count = 0;
+        counted = true;
+    }
+
+    // Number of values in the tree
+    size_t Size() const {
+        if (!counted) {
+            count = 0;
+            InOrder([this](const Value&) {
+                count++;
+            });
+            counted = true;
+        }
+        return count;
+    }
+
+    // Node count, deepest level and average level of the nodes, root is level 1
+    TreeShape Shape() const {
+        TreeShape shape;
+        shape.nodes = 0;
+        shape.maxDepth = 0;
+        shape.averageDepth = 0;
+        size_t depthSum = 0;
+        std::vector<std::pair<const Node*, size_t>> stack;
+        if (root != nullptr) {
+            stack.push_back(std::make_pair(root, (size_t)1));
+        }
+        while (!stack.empty()) {
+            const Node* node = stack.back().first;
+            size_t depth = stack.back().second;
+            stack.pop_back();
+            shape.nodes++;
+            depthSum += depth;
+            if (depth > shape.maxDepth) {
+                shape.maxDepth = depth;
+            }
+            if (node->left != nullptr) {
+                stack.push_back(std::make_pair(node->left, depth + 1));
+            }
+            if (node->right != nullptr) {
+                stack.push_back(std::make_pair(node->right, depth + 1));
+            }
+        }
+        if (shape.nodes > 0) {
+            shape.averageDepth = (double)depthSum / shape.nodes;
+        }
+        return shape;
+    }
+
+    // In-order iterator, holds the path to the current node
+    class const_iterator {
+
+    private:
+        std::vector<const Node*> stack;
+
+        void pushLeft(const Node* node) {
+            while (node != nullptr) {
+                stack.push_back(node);
+                node = node->left;
+            }
+        }
+
+    public:
+        const_iterator() {
+        }
+
+        explicit const_iterator(const Node* root) {
+            pushLeft(root);
+        }
+
+        const Value& operator*() const {
+            return stack.back()->value;
+        }
+
+        const Value* operator->() const {
+            return &stack.back()->value;
+        }
+
+        const_iterator& operator++() {
+            const Node* node = stack.back();
+            stack.pop_back();
+            pushLeft(node->right);
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            if (stack.empty() || other.stack.empty()) {
+                return stack.empty() == other.stack.empty();
+            }
+            return stack.back() == other.stack.back();
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    const_iterator begin() const {
+        return const_iterator(root);
+    }
+
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    // Move every value of other into this tree in O(n + m)
+    //
+    // Both trees are flattened to sorted node lists, merged like merge sort
+    // and relinked balanced. No node is copied or allocated. When both
+    // trees hold a key the value from other wins.
+    void Merge(SearchTree&& other) {
+        if (this == &other) {
+            return;
+        }
+        std::vector<Node*> mine;
+        std::vector<Node*> theirs;
+        flatten(mine);
+        other.flatten(theirs);
+        other.root = nullptr;
+        other.count = 0;
+        other.counted = true;
+
+        std::vector<Node*> merged;
+        merged.reserve(mine.size() + theirs.size());
+        size_t i = 0;
+        size_t j = 0;
+        while (i < mine.size() && j < theirs.size()) {
+            if (less(keyOf(mine[i]->value), keyOf(theirs[j]->value))) {
+                merged.push_back(mine[i++]);
+            }
+            else if (less(keyOf(theirs[j]->value), keyOf(mine[i]->value))) {
+                merged.push_back(theirs[j++]);
+            }
+            else {
+                delete mine[i++];
+                CATALOG_METRIC(bytesFreed, sizeof(Node));
+                merged.push_back(theirs[j++]);
+            }
+        }
+        merged.insert(merged.end(), mine.begin() + i, mine.end());
+        merged.insert(merged.end(), theirs.begin() + j, theirs.end());
+        root = build(merged, 0, merged.size());
+        count = merged.size();
+        counted = true;
+    }
+
+    // Move every value with a key not less than key into a new tree
+    //
+    // Walks one root-to-leaf path, hanging each node on the smaller or the
+    // greater side, so it costs O(height). Neither half is deeper than the
+    // tree was.
+    SearchTree Split(const Key& key) {
+        Node* smaller = nullptr;
+        Node* greater = nullptr;
+        Node** smallerHook = &smaller;
+        Node** greaterHook = &greater;
+        Node* node = root;
+        while (node != nullptr) {
+            if (less(keyOf(node->value), key)) {
+                // node and its left side stay, keep splitting its right side
+                *smallerHook = node;
+                smallerHook = &node->right;
+                node = node->right;
+            }
+            else {
+                *greaterHook = node;
+                greaterHook = &node->left;
+                node = node->left;
+            }
+        }
+        *smallerHook = nullptr;
+        *greaterHook = nullptr;
+
+        SearchTree upper;
+        upper.root = greater;
+        upper.counted = false;
+        root = smaller;
+        counted = false;
+        return upper;
+    }
+
+    // Append a tree whose keys are all greater than every key in this one
+    //
+    // The largest node of this tree is unhooked and becomes the root with
+    // the two trees as its children, O(height) and at most one level deeper
+    // than the deeper tree.
+    void Join(SearchTree&& greater) {
+        if (this == &greater || greater.root == nullptr) {
+            return;
+        }
+        if (root == nullptr) {
+            *this = std::move(greater);
+            return;
+        }
+        Node** link = &root;
+        while ((*link)->right != nullptr) {
+            link = &(*link)->right;
+        }
+        Node* middle = *link;
+        *link = middle->left;
+        middle->left = root;
+        middle->right = greater.root;
+        root = middle;
+
+        count += greater.count;
+        counted = counted && greater.counted;
+        greater.root = nullptr;
+        greater.count = 0;
+        greater.counted = true;
+    }
+
+    // Relink every node into a perfectly balanced tree, O(n) and no allocation
+    void Rebalance() {
+        std::vector<Node*> nodes;
+        flatten(nodes);
+        root = build(nodes, 0, nodes.size());
+    }
+
+    // Visit every value in key order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        std::vector<const Node*> stack;
+        const Node* node = root;
+        while (node != nullptr || !stack.empty()) {
+            // go as far left as possible
+            while (node != nullptr) {
+                stack.push_back(node);
+                node = node->left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            visit(node->value);
+            node = node->right;
+        }
+    }
+
+    // Visit every value with lo <= key <= hi in key order, O(height + matches)
+    template <typename Visit>
+    void Range(const Key& lo, const Key& hi, Visit visit) const {
+        std::vector<const Node*> stack;
+        const Node* node = root;
+        while (node != nullptr || !stack.empty()) {
+            // go left while keys can still reach lo, skip subtrees below it
+            while (node != nullptr) {
+                if (less(keyOf(node->value), lo)) {
+                    node = node->right;
+                }
+                else {
+                    stack.push_back(node);
+                    node = node->left;
+                }
+            }
+            if (stack.empty()) {
+                return;
+            }
+            node = stack.back();
+            stack.pop_back();
+            if (less(hi, keyOf(node->value))) {
+                return;
+            }
+            visit(node->value);
+            node = node->right;
+        }
+    }
+
+    // Print every value in key order with displayRow
+    void InOrder() const {
+        InOrder([](const Value& value) {
+            displayRow(value);
+        });
+    }
+
+    // Insert a value
+    void Insert(const Value& value) {
+        if constexpr (splays) {
+            // splay the key up and put the new node above it
+            size_t compares = splay(keyOf(value));
+            Node* node = new Node(value);
+            if (root != nullptr) {
+                compares++;
+                if (less(keyOf(value), keyOf(root->value))) {
+                    node->left = root->left;
+                    node->right = root;
+                    root->left = nullptr;
+                }
+                else {
+                    node->right = root->right;
+                    node->left = root;
+                    root->right = nullptr;
+                }
+            }
+            root = node;
+            count++;
+            CATALOG_METRIC(inserts, 1);
+            CATALOG_METRIC(insertComparisons, compares);
+            CATALOG_METRIC(bytesAllocated, sizeof(Node));
+            return;
+        }
+
+        // walk down to the empty link where the value belongs
+        size_t compares = 0;
+        Node** link = &root;
+        while (*link != nullptr) {
+            compares++;
+            if (less(keyOf(value), keyOf((*link)->value))) {
+                link = &(*link)->left;
+            }
+            else {
+                link = &(*link)->right;
+            }
+        }
+        *link = new Node(value);
+        count++;
+        CATALOG_METRIC(inserts, 1);
+        CATALOG_METRIC(insertComparisons, compares);
+        CATALOG_METRIC(bytesAllocated, sizeof(Node));
+    }
+
+    // Insert many values at once, in any order
+    //
+    // The batch is sorted and merged into the tree in one top-down pass
+    // instead of one descent from the root per value, subtrees that do not
+    // overlap going to their own threads. Parts of the tree the batch is
+    // dense in come out balanced; should the pass still leave the tree
+    // deeper than four times a balanced one, past what random inserts
+    // reach, it is relinked. Same result as calling Insert for each value
+    // in turn, up to the shape.
+    void InsertBatch(const std::vector<Value>& values) {
+        if (values.empty()) {
+            return;
+        }
+        // the nodes are sorted rather than the values, which may be costly to move
+        std::vector<Node*> fresh;
+        fresh.reserve(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            fresh.push_back(new Node(values[i]));
+        }
+        auto byKey = [](const Node* a, const Node* b) {
+            return less(keyOf(a->value), keyOf(b->value));
+        };
+        if (!std::is_sorted(fresh.begin(), fresh.end(), byKey)) {
+            std::stable_sort(fresh.begin(), fresh.end(), byKey);
+        }
+        unsigned spawn = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        size_t deepest = 0;
+        root = insertSorted(root, fresh.data(), fresh.size(), 0, Size(), spawn, deepest);
+        count += values.size();
+        if (deepest > 4 * balancedHeight(Size())) {
+            Rebalance();
+        }
+        CATALOG_METRIC(inserts, values.size());
+        CATALOG_METRIC(bytesAllocated, values.size() * sizeof(Node));
+    }
+
+    // Remove every value whose key is in the batch, in one pass the same way
+    void RemoveBatch(std::vector<Key> keys) {
+        if (keys.empty() || root == nullptr) {
+            return;
+        }
+        auto byKey = [](const Key& a, const Key& b) {
+            return less(a, b);
+        };
+        // the loader hands its deletes over in key order already
+        if (!std::is_sorted(keys.begin(), keys.end(), byKey)) {
+            std::sort(keys.begin(), keys.end(), byKey);
+        }
+        keys.erase(std::unique(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+            return !less(a, b) && !less(b, a);
+        }), keys.end());
+        unsigned spawn = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        size_t removed = 0;
+        root = removeSorted(root, keys.data(), keys.size(), Size(), spawn, removed);
+        count -= removed;
+        CATALOG_METRIC(removes, removed);
+        CATALOG_METRIC(bytesFreed, removed * sizeof(Node));
+    }
+
+    // Remove the value with a key
+    void Remove(const Key& key) {
+        if constexpr (splays) {
+            size_t compares = splay(key);
+            CATALOG_METRIC(removes, 1);
+            CATALOG_METRIC(removeComparisons, compares);
+            if (root == nullptr || less(key, keyOf(root->value)) || less(keyOf(root->value), key)) {
+                return;
+            }
+            // the largest key on the left comes up, anything right of it is an equal key
+            Node* node = root;
+            if (node->left == nullptr) {
+                root = node->right;
+            }
+            else {
+                root = node->left;
+                splay(key);
+                Node* last = root;
+                while (last->right != nullptr) {
+                    last = last->right;
+                }
+                last->right = node->right;
+            }
+            delete node;
+            count--;
+            CATALOG_METRIC(bytesFreed, sizeof(Node));
+            return;
+        }
+
+        // find the link pointing at the node to remove
+        size_t compares = 0;
+        Node** link = &root;
+        while (*link != nullptr) {
+            compares++;
+            if (less(key, keyOf((*link)->value))) {
+                link = &(*link)->left;
+                continue;
+            }
+            compares++;
+            if (less(keyOf((*link)->value), key)) {
+                link = &(*link)->right;
+            }
+            else {
+                break;
+            }
+        }
+        CATALOG_METRIC(removes, 1);
+        CATALOG_METRIC(removeComparisons, compares);
+        Node* node = *link;
+        if (node == nullptr) {
+            return;
+        }
+
+        if (node->left == nullptr) {
+            *link = node->right;
+        }
+        else if (node->right == nullptr) {
+            *link = node->left;
+        }
+        else {
+            // two children, the smallest node on the right takes its place
+            Node** successor = &node->right;
+            while ((*successor)->left != nullptr) {
+                successor = &(*successor)->left;
+            }
+            Node* next = *successor;
+            *successor = next->right;
+            next->left = node->left;
+            next->right = node->right;
+            *link = next;
+        }
+        delete node;
+        count--;
+        CATALOG_METRIC(bytesFreed, sizeof(Node));
+    }
+
+    // Find the value with a key, nullptr when there is none
+    const Value* Find(const Key& key) const {
+        if constexpr (splays) {
+            size_t compares = splay(key);
+            CATALOG_METRIC(searches, 1);
+            CATALOG_METRIC(searchComparisons, compares);
+            if (root == nullptr || less(key, keyOf(root->value)) || less(keyOf(root->value), key)) {
+                return nullptr;
+            }
+            return &root->value;
+        }
+
+        // keep looping downwards until bottom reached or matching key found
+        size_t depth = 0;
+        size_t compares = 0;
+        Node* current = root;
+        while (current != nullptr) {
+            depth++;
+            compares++;
+            if (less(key, keyOf(current->value))) {
+                current = current->left;
+                continue;
+            }
+            compares++;
+            if (less(keyOf(current->value), key)) {
+                current = current->right;
+            }
+            else {
+                break;
+            }
+        }
+        CATALOG_METRIC(searches, 1);
+        CATALOG_METRIC(searchDepth, depth);
+        CATALOG_METRIC(searchComparisons, compares);
+        return current != nullptr ? &current->value : nullptr;
+    }
+
+    // Search for a value, a default constructed one when there is none
+    Value Search(const Key& key) const {
+        const Value* found = Find(key);
+        if (found != nullptr) {
+            return *found;
+        }
+        return Value();
+    }
+};
+
+#endif
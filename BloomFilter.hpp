@@ -0,0 +1,100 @@
+//============================================================================
+// Name        : BloomFilter.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Blocked Bloom filter over course numbers
+//
+// Every key lands in one 32 byte block and sets one bit in each of the
+// block's eight 32 bit words, the bit picked by multiplying the key hash
+// with a per-word odd constant. A lookup is a single block read, so a key
+// that was never added is turned away after one cache miss instead of a
+// full tree walk. Keys cannot be taken out again; a removed key just
+// stays a false positive until the filter is rebuilt.
+class BloomFilter {
+
+private:
+    struct alignas(32) Block {
+        uint32_t words[8];
+    };
+
+    // about 0.5% false positives at this many bits per key
+    static const size_t BITS_PER_KEY = 12;
+
+    std::vector<Block> blocks;
+
+    static uint64_t hash(const std::string& key) {
+        // std::hash quality varies, finish with a 64 bit mixer
+        uint64_t h = std::hash<std::string>()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // the block a hash falls in, without a division
+    size_t blockOf(uint64_t h) const {
+        return (size_t)(((h >> 32) * (uint64_t)blocks.size()) >> 32);
+    }
+
+    // bit of each word for a hash
+    static void mask(uint32_t key, uint32_t bits[8]) {
+        static const uint32_t salt[8] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+        for (int i = 0; i < 8; i++) {
+            bits[i] = 1u << ((key * salt[i]) >> 27);
+        }
+    }
+
+public:
+    // Empty filter sized for a number of keys; with no size it lets everything pass
+    void Reset(size_t expectedKeys) {
+        size_t count = (expectedKeys * BITS_PER_KEY + 255) / 256;
+        blocks.assign(count, Block());
+    }
+
+    void Add(const std::string& key) {
+        if (blocks.empty()) {
+            return;
+        }
+        uint64_t h = hash(key);
+        Block& block = blocks[blockOf(h)];
+        uint32_t bits[8];
+        mask((uint32_t)h, bits);
+        for (int i = 0; i < 8; i++) {
+            block.words[i] |= bits[i];
+        }
+    }
+
+    // False only when the key was never added
+    bool MayContain(const std::string& key) const {
+        if (blocks.empty()) {
+            return true;
+        }
+        uint64_t h = hash(key);
+        const Block& block = blocks[blockOf(h)];
+        uint32_t bits[8];
+        mask((uint32_t)h, bits);
+        uint32_t missing = 0;
+        for (int i = 0; i < 8; i++) {
+            missing |= bits[i] & ~block.words[i];
+        }
+        return missing == 0;
+    }
+
+    size_t Bytes() const {
+        return blocks.size() * sizeof(Block);
+    }
+};
+
+#endif
@@ -0,0 +1,692 @@
+//============================================================================
+// Name        : CatalogBench.cpp
+// Author      : Paul Velazquez
+//
+// Benchmarks the course tree against the standard containers on synthetic
+// catalogs and prints the results as JSON.
+//
+//   g++ -O2 -std=c++17 -pthread CatalogBench.cpp -o CatalogBench
+//   ./CatalogBench [--n 100000] [--sorted-n 20000] [--queries 1000000] [--seed 42]
+//============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Course.hpp"
+#include "FrozenCatalog.hpp"
+#include "MultiIndexCatalog.hpp"
+#include "ShardedCatalog.hpp"
+
+using namespace std;
+
+//===================
+// Synthetic catalogs
+//===================
+
+// a catalog and the work to run against it
+struct Workload {
+    string catalog;              // key order the courses are loaded in
+    string queries;              // how lookups are distributed
+    vector<Course> courses;      // loaded up front
+    vector<Course> extra;        // inserted and removed afterwards
+    vector<string> lookups;
+    vector<pair<string, string>> ranges;    // about ten courses each
+    vector<string> prefixes;                // about a hundred courses each
+};
+
+static const char* DEPARTMENTS[] = { "CSCI", "MATH", "PHYS", "CHEM", "BIOL", "ENGL", "HIST", "ECON" };
+static const char* WORDS[] = { "Introduction", "to", "Data", "Structures", "Algorithms", "Systems",
+    "Advanced", "Programming", "Theory", "Design", "Analysis", "Applied", "Methods", "Seminar" };
+
+// Make n distinct courses in key order
+vector<Course> makeCourses(size_t n, mt19937_64& rng) {
+    vector<Course> courses(n);
+    size_t perDepartment = (n + 7) / 8;
+    for (size_t i = 0; i < n; i++) {
+        char number[32];
+        snprintf(number, sizeof(number), "%s%06zu", DEPARTMENTS[i / perDepartment], i % perDepartment);
+        courses[i].courseNum = number;
+        size_t words = 2 + rng() % 4;
+        for (size_t w = 0; w < words; w++) {
+            if (w > 0) {
+                courses[i].courseName += ' ';
+            }
+            courses[i].courseName += WORDS[rng() % 14];
+        }
+        size_t prereqs = rng() % 3;
+        for (size_t p = 0; p < prereqs && i > 0; p++) {
+            courses[i].prereqs.push_back(courses[rng() % i].courseNum);
+        }
+    }
+    return courses;
+}
+
+// Indices drawn with probability proportional to 1 / rank^s
+vector<size_t> zipfian(size_t n, size_t count, double s, mt19937_64& rng) {
+    vector<double> cdf(n);
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += 1.0 / pow((double)(i + 1), s);
+        cdf[i] = total;
+    }
+    // hot ranks land on random courses, not on the first few keys
+    vector<size_t> rankToIndex(n);
+    for (size_t i = 0; i < n; i++) {
+        rankToIndex[i] = i;
+    }
+    shuffle(rankToIndex.begin(), rankToIndex.end(), rng);
+
+    uniform_real_distribution<double> unit(0.0, total);
+    vector<size_t> picks(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t rank = lower_bound(cdf.begin(), cdf.end(), unit(rng)) - cdf.begin();
+        picks[i] = rankToIndex[min(rank, n - 1)];
+    }
+    return picks;
+}
+
+// Build one workload, order is "sorted" or "random" and queries "uniform" or "zipf"
+Workload makeWorkload(const string& order, const string& queries, size_t n, size_t lookups, uint64_t seed) {
+    mt19937_64 rng(seed);
+    Workload work;
+    work.catalog = order;
+    work.queries = queries;
+
+    // every tenth course is held back for the insert and remove phases
+    vector<Course> all = makeCourses(n + n / 10, rng);
+    for (size_t i = 0; i < all.size(); i++) {
+        if (i % 11 == 10) {
+            work.extra.push_back(all[i]);
+        }
+        else {
+            work.courses.push_back(all[i]);
+        }
+    }
+    if (order == "random") {
+        shuffle(work.courses.begin(), work.courses.end(), rng);
+    }
+    shuffle(work.extra.begin(), work.extra.end(), rng);
+
+    vector<size_t> picks;
+    if (queries == "zipf") {
+        picks = zipfian(work.courses.size(), lookups, 0.99, rng);
+    }
+    else {
+        picks.resize(lookups);
+        for (size_t i = 0; i < lookups; i++) {
+            picks[i] = rng() % work.courses.size();
+        }
+    }
+    work.lookups.resize(lookups);
+    for (size_t i = 0; i < lookups; i++) {
+        work.lookups[i] = work.courses[picks[i]].courseNum;
+    }
+
+    // ordered queries start at the same courses, a tenth as many
+    vector<string> sorted(work.courses.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        sorted[i] = work.courses[i].courseNum;
+    }
+    sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < lookups; i += 10) {
+        const string& key = work.lookups[i];
+        size_t at = lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+        work.ranges.push_back(make_pair(key, sorted[min(at + 9, sorted.size() - 1)]));
+        // drop the last two digits, the other courses of that hundred
+        work.prefixes.push_back(key.substr(0, key.size() - 2));
+    }
+    return work;
+}
+
+//=======================
+// Engines under the test
+//=======================
+
+// bytes a key string takes, counting its heap buffer when it has one
+static size_t keyBytes(const string& key) {
+    return sizeof(string) + (key.capacity() > 15 ? key.capacity() + 1 : 0);
+}
+
+// every course number is ASCII, so the ones starting with prefix all sort
+// at or below this
+static string prefixEnd(const string& prefix) {
+    return prefix + '\xff';
+}
+
+// engines that take updates; read-only ones skip the insert and remove phases
+struct MutableEngine {
+    static const bool readOnly = false;
+    // engines that keep key order also run the range and prefix phases
+    static const bool ordered = false;
+    // engines with one call for many updates also run the batch phases
+    static const bool batches = false;
+    // engines that find a block before scanning it also time that alone
+    static const bool blocks = false;
+    size_t range(const string&, const string&) { return 0; }
+    size_t prefix(const string&) { return 0; }
+    // bytes of the nodes and of the part of them a search reads, trees only
+    long nodeBytes() { return -1; }
+    long hotBytes() { return -1; }
+};
+
+// the course tree as the program uses it, left in insertion shape
+template <typename Tree>
+struct TreeEngine : MutableEngine {
+    static const char* name() { return "bst"; }
+    static const bool ordered = true;
+    static const bool batches = true;
+    Tree tree;
+    void load(const vector<Course>& courses) {
+        for (size_t i = 0; i < courses.size(); i++) {
+            tree.Insert(courses[i]);
+        }
+    }
+    void insert(const Course& course) { tree.Insert(course); }
+    bool search(const string& key) { return tree.Find(key) != nullptr; }
+    void remove(const string& key) { tree.Remove(key); }
+    void insertBatch(const vector<Course>& courses) { tree.InsertBatch(courses); }
+    void removeBatch(const vector<string>& keys) { tree.RemoveBatch(keys); }
+    size_t range(const string& lo, const string& hi) {
+        size_t found = 0;
+        tree.Range(lo, hi, [&](const Course&) { found++; });
+        return found;
+    }
+    size_t prefix(const string& p) { return range(p, prefixEnd(p)); }
+    size_t traverse() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += ::keyBytes(course.courseNum); });
+        return sum;
+    }
+    // a search reads the key and both links of every node on its path
+    long nodeBytes() { return (long)(tree.Size() * sizeof(typename Tree::Node)); }
+    long hotBytes() { return (long)(tree.Size() * (sizeof(string) + 2 * sizeof(void*))); }
+};
+
+// relinked into a perfectly balanced tree after the load
+struct BalancedTreeEngine : TreeEngine<BinarySearchTree> {
+    static const char* name() { return "bst-balanced"; }
+    void load(const vector<Course>& courses) {
+        TreeEngine<BinarySearchTree>::load(courses);
+        tree.Rebalance();
+    }
+};
+
+// every access splays, hot courses collect near the root
+struct SplayTreeEngine : TreeEngine<SplayCourseTree> {
+    static const char* name() { return "bst-splay"; }
+};
+
+// keys and 32 bit links in one array, courses in another, balanced after the load
+struct IndexedTreeEngine : MutableEngine {
+    static const char* name() { return "bst-indexed"; }
+    IndexedCourseTree tree;
+    void load(const vector<Course>& courses) {
+        for (size_t i = 0; i < courses.size(); i++) {
+            tree.Insert(courses[i]);
+        }
+        tree.Rebalance();
+    }
+    void insert(const Course& course) { tree.Insert(course); }
+    bool search(const string& key) { return tree.Find(key) != nullptr; }
+    void remove(const string& key) { tree.Remove(key); }
+    size_t traverse() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += ::keyBytes(course.courseNum); });
+        return sum;
+    }
+    long nodeBytes() { return (long)(tree.HotBytes() + tree.ColdBytes()); }
+    long hotBytes() { return (long)tree.HotBytes(); }
+};
+
+// adaptive radix tree, one level per byte of the course number
+struct RadixTreeEngine : MutableEngine {
+    static const char* name() { return "art"; }
+    static const bool ordered = true;
+    RadixCourseTree tree;
+    void load(const vector<Course>& courses) {
+        for (size_t i = 0; i < courses.size(); i++) {
+            tree.Insert(courses[i]);
+        }
+    }
+    void insert(const Course& course) { tree.Insert(course); }
+    bool search(const string& key) { return tree.Find(key) != nullptr; }
+    void remove(const string& key) { tree.Remove(key); }
+    size_t range(const string& lo, const string& hi) {
+        size_t found = 0;
+        tree.Range(lo, hi, [&](const Course&) { found++; });
+        return found;
+    }
+    size_t prefix(const string& p) {
+        size_t found = 0;
+        tree.Prefix(p, [&](const Course&) { found++; });
+        return found;
+    }
+    size_t traverse() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += ::keyBytes(course.courseNum); });
+        return sum;
+    }
+    // a search reads inner nodes down to one leaf
+    long nodeBytes() { return (long)(tree.InnerBytes() + tree.LeafBytes()); }
+    long hotBytes() { return (long)tree.InnerBytes(); }
+};
+
+// the same nodes linked by number, by name and by department; updates pay
+// for keeping all three
+struct MultiIndexEngine : MutableEngine {
+    static const char* name() { return "multi-index"; }
+    static const bool ordered = true;
+    MultiIndexCatalog tree;
+    void load(const vector<Course>& courses) {
+        for (size_t i = 0; i < courses.size(); i++) {
+            tree.Insert(courses[i]);
+        }
+    }
+    void insert(const Course& course) { tree.Insert(course); }
+    bool search(const string& key) { return tree.Find(key) != nullptr; }
+    void remove(const string& key) { tree.Remove(key); }
+    size_t range(const string& lo, const string& hi) {
+        size_t found = 0;
+        tree.Range(lo, hi, [&](const Course&) { found++; });
+        return found;
+    }
+    size_t prefix(const string& p) { return range(p, prefixEnd(p)); }
+    size_t traverse() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        tree.InOrder([&](const Course& course) { sum += ::keyBytes(course.courseNum); });
+        return sum;
+    }
+    // a search reads the key and the number links of every node on its path
+    long nodeBytes() { return (long)(tree.Size() * sizeof(MultiIndexCatalog::Node)); }
+    long hotBytes() { return (long)(tree.Size() * (sizeof(string) + 2 * sizeof(void*))); }
+};
+
+struct MapEngine : MutableEngine {
+    static const char* name() { return "std::map"; }
+    static const bool ordered = true;
+    map<string, Course> courses;
+    void load(const vector<Course>& all) {
+        for (size_t i = 0; i < all.size(); i++) {
+            courses.emplace(all[i].courseNum, all[i]);
+        }
+    }
+    void insert(const Course& course) { courses.emplace(course.courseNum, course); }
+    bool search(const string& key) { return courses.find(key) != courses.end(); }
+    void remove(const string& key) { courses.erase(key); }
+    size_t range(const string& lo, const string& hi) {
+        size_t found = 0;
+        for (auto it = courses.lower_bound(lo); it != courses.end() && !(hi < it->first); ++it) {
+            found++;
+        }
+        return found;
+    }
+    size_t prefix(const string& p) { return range(p, prefixEnd(p)); }
+    size_t traverse() {
+        size_t sum = 0;
+        for (auto& entry : courses) {
+            sum += entry.second.prereqs.size();
+        }
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        for (auto& entry : courses) {
+            sum += ::keyBytes(entry.first) + ::keyBytes(entry.second.courseNum);
+        }
+        return sum;
+    }
+};
+
+struct HashEngine : MutableEngine {
+    static const char* name() { return "std::unordered_map"; }
+    unordered_map<string, Course> courses;
+    void load(const vector<Course>& all) {
+        courses.reserve(all.size());
+        for (size_t i = 0; i < all.size(); i++) {
+            courses.emplace(all[i].courseNum, all[i]);
+        }
+    }
+    void insert(const Course& course) { courses.emplace(course.courseNum, course); }
+    bool search(const string& key) { return courses.find(key) != courses.end(); }
+    void remove(const string& key) { courses.erase(key); }
+    // unordered, so the traversal is not in key order
+    size_t traverse() {
+        size_t sum = 0;
+        for (auto& entry : courses) {
+            sum += entry.second.prereqs.size();
+        }
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        for (auto& entry : courses) {
+            sum += ::keyBytes(entry.first) + ::keyBytes(entry.second.courseNum);
+        }
+        return sum;
+    }
+};
+
+// sorted vector searched with lower_bound
+struct FlatEngine : MutableEngine {
+    static const char* name() { return "flat_map"; }
+    static const bool ordered = true;
+    vector<Course> courses;
+    static bool byKey(const Course& a, const Course& b) { return a.courseNum < b.courseNum; }
+    vector<Course>::iterator at(const string& key) {
+        return lower_bound(courses.begin(), courses.end(), key,
+            [](const Course& course, const string& k) { return course.courseNum < k; });
+    }
+    void load(const vector<Course>& all) {
+        courses = all;
+        sort(courses.begin(), courses.end(), byKey);
+    }
+    void insert(const Course& course) { courses.insert(at(course.courseNum), course); }
+    bool search(const string& key) {
+        auto found = at(key);
+        return found != courses.end() && found->courseNum == key;
+    }
+    void remove(const string& key) {
+        auto found = at(key);
+        if (found != courses.end() && found->courseNum == key) {
+            courses.erase(found);
+        }
+    }
+    size_t range(const string& lo, const string& hi) {
+        size_t found = 0;
+        for (auto it = at(lo); it != courses.end() && !(hi < it->courseNum); ++it) {
+            found++;
+        }
+        return found;
+    }
+    size_t prefix(const string& p) { return range(p, prefixEnd(p)); }
+    size_t traverse() {
+        size_t sum = 0;
+        for (size_t i = 0; i < courses.size(); i++) {
+            sum += courses[i].prereqs.size();
+        }
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        for (size_t i = 0; i < courses.size(); i++) {
+            sum += ::keyBytes(courses[i].courseNum);
+        }
+        return sum;
+    }
+};
+
+// one tree per department group, shards built in parallel
+struct ShardedEngine : MutableEngine {
+    static const char* name() { return "sharded"; }
+    ShardedCatalog catalog;
+    void load(const vector<Course>& all) { catalog.Load(all); }
+    void insert(const Course& course) { catalog.Insert(course); }
+    bool search(const string& key) { return !catalog.Search(key).courseNum.empty(); }
+    void remove(const string& key) { catalog.Remove(key); }
+    size_t traverse() {
+        size_t sum = 0;
+        catalog.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() {
+        size_t sum = 0;
+        catalog.InOrder([&](const Course& course) { sum += ::keyBytes(course.courseNum); });
+        return sum;
+    }
+};
+
+// read-only snapshot with front coded keys, the block of a key found by Search
+template <FrozenCatalog::HeadSearch Search>
+struct FrozenEngineOf {
+    static const bool readOnly = true;
+    static const bool ordered = false;
+    static const bool batches = false;
+    static const bool blocks = true;
+    FrozenCatalog catalog;
+    void load(const vector<Course>& all) {
+        vector<Course> sorted(all);
+        sort(sorted.begin(), sorted.end(), FlatEngine::byKey);
+        for (size_t i = 0; i < sorted.size(); i++) {
+            catalog.Add(sorted[i]);
+        }
+        catalog.UseHeadSearch(Search);
+    }
+    bool search(const string& key) { return catalog.Contains(key); }
+    size_t block(const string& key) { return catalog.BlockOf(key); }
+    size_t traverse() {
+        size_t sum = 0;
+        catalog.InOrder([&](const Course& course) { sum += course.prereqs.size(); });
+        return sum;
+    }
+    size_t keyBytes() { return catalog.KeyBytes(); }
+    long nodeBytes() { return -1; }
+    long hotBytes() { return -1; }
+};
+
+struct FrozenEngine : FrozenEngineOf<FrozenCatalog::HEAD_BINARY> {
+    static const char* name() { return "frozen"; }
+};
+
+struct EytzingerFrozenEngine : FrozenEngineOf<FrozenCatalog::HEAD_EYTZINGER> {
+    static const char* name() { return "frozen-eytzinger"; }
+};
+
+// the block heads go through a LearnedIndex, a PGM-style spline with a
+// bounded error at every level, that predicts the block
+struct LearnedFrozenEngine : FrozenEngineOf<FrozenCatalog::HEAD_LEARNED> {
+    static const char* name() { return "frozen-learned"; }
+};
+
+//==========
+// Harness
+//==========
+
+typedef chrono::steady_clock Clock;
+
+static double nanosSince(Clock::time_point start) {
+    return (double)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Run every phase of one workload against one engine and print a JSON object
+template <typename Engine>
+void runEngine(const Workload& work, bool first) {
+    Engine engine;
+    size_t checksum = 0;
+
+    Clock::time_point start = Clock::now();
+    engine.load(work.courses);
+    double load = nanosSince(start);
+
+    size_t keys = engine.keyBytes();
+    long nodes = engine.nodeBytes();
+    long hot = engine.hotBytes();
+
+    double insert = -1;
+    if constexpr (!Engine::readOnly) {
+        start = Clock::now();
+        for (size_t i = 0; i < work.extra.size(); i++) {
+            engine.insert(work.extra[i]);
+        }
+        insert = nanosSince(start);
+    }
+
+    start = Clock::now();
+    for (size_t i = 0; i < work.lookups.size(); i++) {
+        checksum += engine.search(work.lookups[i]) ? 1 : 0;
+    }
+    double search = nanosSince(start);
+
+    // the same lookups again stopping once the block is found, the part
+    // the head search decides
+    double block = -1;
+    if constexpr (Engine::blocks) {
+        start = Clock::now();
+        for (size_t i = 0; i < work.lookups.size(); i++) {
+            checksum += engine.block(work.lookups[i]);
+        }
+        block = nanosSince(start);
+    }
+
+    double range = -1;
+    double prefix = -1;
+    if constexpr (Engine::ordered) {
+        start = Clock::now();
+        for (size_t i = 0; i < work.ranges.size(); i++) {
+            checksum += engine.range(work.ranges[i].first, work.ranges[i].second);
+        }
+        range = nanosSince(start);
+        start = Clock::now();
+        for (size_t i = 0; i < work.prefixes.size(); i++) {
+            checksum += engine.prefix(work.prefixes[i]);
+        }
+        prefix = nanosSince(start);
+    }
+
+    start = Clock::now();
+    checksum += engine.traverse();
+    double traverse = nanosSince(start);
+
+    double remove = -1;
+    if constexpr (!Engine::readOnly) {
+        start = Clock::now();
+        for (size_t i = 0; i < work.extra.size(); i++) {
+            engine.remove(work.extra[i].courseNum);
+        }
+        remove = nanosSince(start);
+    }
+
+    // the same updates again as one batch each, against the per-item loops above
+    double insertBatch = -1;
+    double removeBatch = -1;
+    if constexpr (Engine::batches) {
+        vector<string> keys;
+        for (size_t i = 0; i < work.extra.size(); i++) {
+            keys.push_back(work.extra[i].courseNum);
+        }
+        start = Clock::now();
+        engine.insertBatch(work.extra);
+        insertBatch = nanosSince(start);
+        start = Clock::now();
+        engine.removeBatch(keys);
+        removeBatch = nanosSince(start);
+    }
+
+    // read-only engines report null for the update phases, unordered ones for
+    // range and prefix, engines without batch updates for the batch phases
+    // and engines without blocks for the block phase
+    double updates = (double)max<size_t>(work.extra.size(), 1);
+    string insertField = insert < 0 ? string("null") : to_string(insert / updates);
+    string removeField = remove < 0 ? string("null") : to_string(remove / updates);
+    string insertBatchField = insertBatch < 0 ? string("null") : to_string(insertBatch / updates);
+    string removeBatchField = removeBatch < 0 ? string("null") : to_string(removeBatch / updates);
+    double ordered = (double)max<size_t>(work.ranges.size(), 1);
+    string rangeField = range < 0 ? string("null") : to_string(range / ordered);
+    string prefixField = prefix < 0 ? string("null") : to_string(prefix / ordered);
+    string blockField = block < 0 ? string("null") : to_string(block / max<size_t>(work.lookups.size(), 1));
+    cout << (first ? "\n" : ",\n")
+        << "    {\"engine\": \"" << Engine::name() << "\""
+        << ", \"catalog\": \"" << work.catalog << "\""
+        << ", \"queries\": \"" << work.queries << "\""
+        << ", \"n\": " << work.courses.size()
+        << ", \"load_ms\": " << load / 1e6
+        << ", \"key_bytes\": " << keys
+        << ", \"node_bytes\": " << (nodes < 0 ? string("null") : to_string(nodes))
+        << ", \"hot_bytes\": " << (hot < 0 ? string("null") : to_string(hot))
+        << ", \"insert_ns_per_op\": " << insertField
+        << ", \"search_ns_per_op\": " << search / max<size_t>(work.lookups.size(), 1)
+        << ", \"block_ns_per_op\": " << blockField
+        << ", \"remove_ns_per_op\": " << removeField
+        << ", \"insert_batch_ns_per_op\": " << insertBatchField
+        << ", \"remove_batch_ns_per_op\": " << removeBatchField
+        << ", \"range_ns_per_op\": " << rangeField
+        << ", \"prefix_ns_per_op\": " << prefixField
+        << ", \"traverse_ms\": " << traverse / 1e6
+        << ", \"checksum\": " << checksum << "}";
+}
+
+// Run every engine against one workload
+void runAll(const Workload& work, bool& first) {
+    runEngine<TreeEngine<BinarySearchTree>>(work, first);
+    first = false;
+    runEngine<BalancedTreeEngine>(work, first);
+    runEngine<SplayTreeEngine>(work, first);
+    runEngine<IndexedTreeEngine>(work, first);
+    runEngine<RadixTreeEngine>(work, first);
+    runEngine<MultiIndexEngine>(work, first);
+    runEngine<MapEngine>(work, first);
+    runEngine<HashEngine>(work, first);
+    runEngine<FlatEngine>(work, first);
+    runEngine<ShardedEngine>(work, first);
+    runEngine<FrozenEngine>(work, first);
+    runEngine<EytzingerFrozenEngine>(work, first);
+    runEngine<LearnedFrozenEngine>(work, first);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 100000;
+    // a plain tree loaded in key order is a linked list, keep that case small
+    size_t sortedN = 20000;
+    size_t queries = 1000000;
+    uint64_t seed = 42;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--n") == 0) {
+            n = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--sorted-n") == 0) {
+            sortedN = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--queries") == 0) {
+            queries = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else {
+            cerr << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    cout << "{\n  \"benchmark\": \"catalog\",\n  \"seed\": " << seed << ",\n  \"results\": [";
+    bool first = true;
+    const char* mixes[] = { "uniform", "zipf" };
+    for (int m = 0; m < 2; m++) {
+        runAll(makeWorkload("random", mixes[m], n, queries, seed), first);
+        runAll(makeWorkload("sorted", mixes[m], sortedN, queries, seed), first);
+    }
+    cout << "\n  ]\n}" << endl;
+
+    return 0;
+}
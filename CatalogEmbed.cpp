@@ -0,0 +1,208 @@
+//============================================================================
+// Name        : CatalogEmbed.cpp
+// Author      : Paul Velazquez
+//
+// Turns the course CSV into a header holding the whole catalog as
+// constexpr data with a perfect hash the compiler works out, for builds
+// that ship a fixed catalog. Rows follow the same rules as the program's
+// loader: a later row replaces an earlier one with the same course number,
+// the numeric fields at the end are credits, cap and fee, anything before
+// them a prerequisite.
+//
+//   g++ -O2 -std=c++17 CatalogEmbed.cpp -o CatalogEmbed
+//   ./CatalogEmbed courses.csv [--name kiosk] > KioskCatalog.hpp
+//
+// The header defines <name>Catalog, an EmbeddedCatalog with the Search
+// style API of the trees.
+//============================================================================
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Course.hpp"
+#include "CourseColumns.hpp"
+
+using namespace std;
+
+// Build a course from one CSV line
+Course parseCourse(const string& line) {
+    vector<string> row;
+    string word;
+    stringstream str(line);
+
+    while (getline(str, word, ','))
+        row.push_back(word);
+
+    Course course;
+    course.courseNum = row[0];
+    if (row.size() >= 2) {
+        course.courseName = row[1];
+    }
+    size_t attributes = attributeStart(row, 2);
+    for (size_t i = 2; i < row.size(); i++) {
+        if (i >= attributes) {
+            course.attributes.push_back(row[i]);
+        }
+        else {
+            course.prereqs.push_back(row[i]);
+        }
+    }
+    return course;
+}
+
+// Every course of the CSV by course number, false when it cannot be read
+bool readCourses(const string& csvPath, map<string, Course>* courses) {
+    string line;
+
+    fstream file(csvPath, ios::in);
+    if (!file.is_open()) {
+        return false;
+    }
+    while (getline(file, line)) {
+        // tolerate files saved with windows line endings
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        Course course = parseCourse(line);
+        (*courses)[course.courseNum] = course;
+    }
+    return true;
+}
+
+// Whether name can start the C++ identifiers the header declares
+bool isIdentifier(const string& name) {
+    if (name.empty() || isdigit((unsigned char)name[0])) {
+        return false;
+    }
+    for (unsigned char c : name) {
+        if (!isalnum(c) && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A C++ string literal for text, octal escapes so a following digit is safe
+string literal(const string& text) {
+    string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        }
+        else if (c < 0x20 || c >= 0x7f) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\%03o", c);
+            out += escape;
+        }
+        else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+int main(int argc, char* argv[]) {
+    string csvPath;
+    string name = "kiosk";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        }
+        else if (csvPath.empty() && argv[i][0] != '-') {
+            csvPath = argv[i];
+        }
+        else {
+            cerr << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (csvPath.empty() || name.empty()) {
+        cerr << "usage: CatalogEmbed courses.csv [--name kiosk]" << endl;
+        return 1;
+    }
+    if (!isIdentifier(name)) {
+        cerr << "--name must be a C++ identifier, letters, digits and '_'" << endl;
+        return 1;
+    }
+
+    map<string, Course> courses;
+    if (!readCourses(csvPath, &courses)) {
+        cerr << "could not read " << csvPath << endl;
+        return 1;
+    }
+    if (courses.empty()) {
+        cerr << csvPath << " has no courses" << endl;
+        return 1;
+    }
+
+    string guard = name;
+    transform(guard.begin(), guard.end(), guard.begin(), [](unsigned char c) {
+        return isalnum(c) ? (char)toupper(c) : '_';
+    });
+    guard += "_CATALOG_HPP";
+
+    ostream& out = cout;
+    out << "//============================================================================" << endl;
+    out << "// Generated by CatalogEmbed from " << csvPath << ", do not edit" << endl;
+    out << "//============================================================================" << endl;
+    out << endl;
+    out << "#ifndef " << guard << endl;
+    out << "#define " << guard << endl;
+    out << endl;
+    out << "#include \"EmbeddedCatalog.hpp\"" << endl;
+    out << endl;
+
+    // prerequisites and numeric fields of every course, one after another
+    out << "constexpr std::string_view " << name << "Fields[] = {" << endl;
+    size_t fields = 0;
+    for (const auto& entry : courses) {
+        const Course& course = entry.second;
+        for (size_t i = 0; i < course.prereqs.size(); i++, fields++) {
+            out << "    " << literal(course.prereqs[i]) << "," << endl;
+        }
+        for (size_t i = 0; i < course.attributes.size(); i++, fields++) {
+            out << "    " << literal(course.attributes[i]) << "," << endl;
+        }
+    }
+    if (fields == 0) {
+        // an array cannot be empty
+        out << "    \"\"," << endl;
+    }
+    out << "};" << endl;
+    out << endl;
+
+    out << "constexpr EmbeddedCourse " << name << "Courses[] = {" << endl;
+    size_t at = 0;
+    for (const auto& entry : courses) {
+        const Course& course = entry.second;
+        size_t prereqAt = at;
+        size_t attributeAt = at + course.prereqs.size();
+        at = attributeAt + course.attributes.size();
+        out << "    { " << literal(course.courseNum) << ", " << literal(course.courseName) << ", "
+            << name << "Fields + " << prereqAt << ", " << course.prereqs.size() << ", "
+            << name << "Fields + " << attributeAt << ", " << course.attributes.size() << " }," << endl;
+    }
+    out << "};" << endl;
+    out << endl;
+
+    out << "constexpr EmbeddedCatalog<" << courses.size() << "> " << name << "Catalog(" << name << "Courses);" << endl;
+    out << "static_assert(" << name << "Catalog.Built(), \"no perfect hash found for the " << name << " catalog\");" << endl;
+    out << endl;
+    out << "#endif" << endl;
+
+    cerr << courses.size() << " courses written" << endl;
+    return 0;
+}
@@ -0,0 +1,341 @@
+//============================================================================
+// Name        : CatalogExport.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef CATALOG_EXPORT_HPP
+#define CATALOG_EXPORT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#define CATALOG_EXPORT_POSIX
+#endif
+
+#include "Course.hpp"
+#include "CourseColumns.hpp"
+
+enum ExportFormat { EXPORT_CSV, EXPORT_JSON, EXPORT_NDJSON };
+
+// Buffered file output for the exporters
+//
+// Output is formatted straight into one page aligned 1 MiB buffer that is
+// handed to write() whenever it fills, so the file is written in a few
+// large sequential calls. Builds without POSIX files fall back to fwrite.
+class ExportWriter {
+
+private:
+    struct alignas(4096) Page {
+        char bytes[4096];
+    };
+
+    static const size_t PAGES = 256;
+    static const size_t CAPACITY = PAGES * sizeof(Page);
+
+    Page* pages;
+    char* buffer;
+    size_t used;
+    uint64_t written;
+    bool failed;
+#ifdef CATALOG_EXPORT_POSIX
+    int fd;
+#else
+    FILE* file;
+#endif
+
+    // hand len bytes to the file, retrying short writes
+    void writeOut(const char* data, size_t len) {
+        if (failed) {
+            return;
+        }
+#ifdef CATALOG_EXPORT_POSIX
+        while (len > 0) {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failed = true;
+                return;
+            }
+            data += n;
+            len -= (size_t)n;
+            written += (uint64_t)n;
+        }
+#else
+        if (fwrite(data, 1, len, file) != len) {
+            failed = true;
+            return;
+        }
+        written += len;
+#endif
+    }
+
+    void flush() {
+        writeOut(buffer, used);
+        used = 0;
+    }
+
+public:
+    ExportWriter() {
+        pages = new Page[PAGES];
+        buffer = pages[0].bytes;
+        used = 0;
+        written = 0;
+        failed = true;
+#ifdef CATALOG_EXPORT_POSIX
+        fd = -1;
+#else
+        file = nullptr;
+#endif
+    }
+
+    ~ExportWriter() {
+        Close();
+        delete[] pages;
+    }
+
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    // Create or truncate the output file
+    bool Open(const std::string& path) {
+        Close();
+        used = 0;
+        written = 0;
+#ifdef CATALOG_EXPORT_POSIX
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed = fd < 0;
+#else
+        file = fopen(path.c_str(), "wb");
+        failed = file == nullptr;
+#endif
+        return !failed;
+    }
+
+    // Flush and close, false if anything failed to reach the file
+    bool Close() {
+#ifdef CATALOG_EXPORT_POSIX
+        if (fd < 0) {
+            return !failed;
+        }
+        flush();
+        if (::close(fd) != 0) {
+            failed = true;
+        }
+        fd = -1;
+#else
+        if (file == nullptr) {
+            return !failed;
+        }
+        flush();
+        if (fclose(file) != 0) {
+            failed = true;
+        }
+        file = nullptr;
+#endif
+        return !failed;
+    }
+
+    // Bytes that have reached the file so far
+    uint64_t Written() const {
+        return written;
+    }
+
+    void Put(char c) {
+        if (used == CAPACITY) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void Put(const char* data, size_t len) {
+        if (len > CAPACITY - used) {
+            flush();
+            if (len >= CAPACITY) {
+                writeOut(data, len);
+                return;
+            }
+        }
+        memcpy(buffer + used, data, len);
+        used += len;
+    }
+
+    void Put(const std::string& text) {
+        Put(text.data(), text.size());
+    }
+
+    // a string literal, its length known at compile time
+    template <size_t N>
+    void Put(const char (&text)[N]) {
+        Put(text, N - 1);
+    }
+
+    // Decimal digits of a number, two at a time from a table
+    void PutUnsigned(uint64_t value) {
+        static const char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char digits[20];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        while (value >= 100) {
+            size_t pair = (size_t)(value % 100) * 2;
+            value /= 100;
+            *--p = pairs[pair + 1];
+            *--p = pairs[pair];
+        }
+        if (value >= 10) {
+            *--p = pairs[value * 2 + 1];
+            *--p = pairs[value * 2];
+        }
+        else {
+            *--p = (char)('0' + value);
+        }
+        Put(p, (size_t)(end - p));
+    }
+
+    // A non-negative number with at most two decimals, "3", "3.5" or "1250.25"
+    void PutFixed2(double value) {
+        uint64_t cents = (uint64_t)(value * 100 + 0.5);
+        PutUnsigned(cents / 100);
+        uint64_t fraction = cents % 100;
+        if (fraction != 0) {
+            Put('.');
+            Put((char)('0' + fraction / 10));
+            if (fraction % 10 != 0) {
+                Put((char)('0' + fraction % 10));
+            }
+        }
+    }
+
+    // A quoted JSON string, runs that need no escaping are copied whole
+    void PutJsonString(const std::string& text) {
+        static const char hex[] = "0123456789abcdef";
+        Put('"');
+        size_t run = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            unsigned char c = (unsigned char)text[i];
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            Put(text.data() + run, i - run);
+            run = i + 1;
+            Put('\\');
+            if (c == '"' || c == '\\') {
+                Put((char)c);
+            }
+            else if (c == '\n') {
+                Put('n');
+            }
+            else if (c == '\t') {
+                Put('t');
+            }
+            else {
+                char escape[5] = { 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+                Put(escape, sizeof(escape));
+            }
+        }
+        Put(text.data() + run, text.size() - run);
+        Put('"');
+    }
+};
+
+// One course in the loader's CSV format: number,name[,prereq...][,credits[,cap[,fee]]]
+inline void exportCsvRow(ExportWriter& out, const Course& course) {
+    out.Put(course.courseNum);
+    out.Put(',');
+    out.Put(course.courseName);
+    for (size_t i = 0; i < course.prereqs.size(); i++) {
+        out.Put(',');
+        out.Put(course.prereqs[i]);
+    }
+    for (size_t i = 0; i < course.attributes.size(); i++) {
+        out.Put(',');
+        out.Put(course.attributes[i]);
+    }
+    out.Put('\n');
+}
+
+// One course as a JSON object, without a line break
+inline void exportJsonObject(ExportWriter& out, const Course& course) {
+    out.Put("{\"courseNum\":");
+    out.PutJsonString(course.courseNum);
+    out.Put(",\"courseName\":");
+    out.PutJsonString(course.courseName);
+    out.Put(",\"prereqs\":[");
+    for (size_t i = 0; i < course.prereqs.size(); i++) {
+        if (i > 0) {
+            out.Put(',');
+        }
+        out.PutJsonString(course.prereqs[i]);
+    }
+    out.Put(']');
+    static const char* const fields[COLUMN_COUNT] = { ",\"credits\":", ",\"cap\":", ",\"fee\":" };
+    for (size_t i = 0; i < course.attributes.size() && i < COLUMN_COUNT; i++) {
+        double value;
+        if (parseNumberField(course.attributes[i], &value)) {
+            out.Put(fields[i], strlen(fields[i]));
+            out.PutFixed2(value);
+        }
+    }
+    out.Put('}');
+}
+
+// Write every course of a tree to a file in key order
+//
+// CSV is what the loader reads, written in canonical form: fields in the
+// order they were read, '\n' line ends, and no trailing empty fields past
+// the name, so a bare "CS1" row comes out as "CS1,". Loading an export
+// gives the same catalog and exporting that again gives the same bytes,
+// but the first export of a hand-written file may differ from it where
+// the file was not canonical. JSON is one array; NDJSON is one object per
+// line. Returns false if the file could not be written, bytes gets the
+// size of the output.
+template <typename Tree>
+bool exportCatalog(const Tree& tree, ExportFormat format, const std::string& path, uint64_t* bytes) {
+    ExportWriter out;
+    if (!out.Open(path)) {
+        return false;
+    }
+    if (format == EXPORT_JSON) {
+        out.Put('[');
+    }
+    bool first = true;
+    tree.InOrder([&](const Course& course) {
+        switch (format) {
+        case EXPORT_CSV:
+            exportCsvRow(out, course);
+            break;
+        case EXPORT_JSON:
+            if (!first) {
+                out.Put(',');
+            }
+            out.Put('\n');
+            exportJsonObject(out, course);
+            break;
+        case EXPORT_NDJSON:
+            exportJsonObject(out, course);
+            out.Put('\n');
+            break;
+        }
+        first = false;
+    });
+    if (format == EXPORT_JSON) {
+        out.Put("\n]\n");
+    }
+    bool ok = out.Close();
+    if (bytes != nullptr) {
+        *bytes = out.Written();
+    }
+    return ok;
+}
+
+#endif
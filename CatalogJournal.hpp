@@ -0,0 +1,593 @@
+//============================================================================
+// Name        : CatalogJournal.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef CATALOG_JOURNAL_HPP
+#define CATALOG_JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CATALOG_JOURNAL_POSIX
+#endif
+
+#include "Course.hpp"
+
+// What an edit log record does to the catalog
+enum JournalOp { JOURNAL_INSERT = 1, JOURNAL_REMOVE = 2 };
+
+// How much a restart read back
+struct JournalRecovery {
+    uint64_t snapshotCourses;   // courses in the snapshot
+    uint64_t replayed;          // log records newer than the snapshot
+    uint64_t droppedBytes;      // torn or corrupt tail cut off the log
+    bool snapshotCorrupt;       // snapshot present but failed its checksum
+};
+
+// Binary snapshot of the catalog plus an append-only log of the edits since
+//
+// Every Insert or Remove made through the program becomes one log record
+// with a sequence number. Append queues the record in memory and Sync
+// makes it durable: whichever caller gets there first writes every queued
+// record with one write() and one fdatasync() while later callers wait for
+// that flush, so edits arriving together share a single disk sync.
+//
+// The snapshot holds every course in key order and the sequence number of
+// the last edit it includes. A restart maps it in, then replays the log
+// records after that number. Compact writes a new snapshot beside the old
+// one, renames it into place and rewrites the log without the records the
+// snapshot now covers, so the log stays short however long the program runs.
+//
+// Records are length, checksum and payload, so a record torn by a crash is
+// found on replay and cut off. Builds without POSIX files keep no journal.
+class CatalogJournal {
+
+private:
+    static const uint64_t SNAPSHOT_MAGIC = 0x31504e5354414343ULL;   // "CCATSNP1" little endian
+    static const size_t SNAPSHOT_HEADER = 40;
+    static const size_t RECORD_HEADER = 8;
+
+    std::string snapshotPath;
+    std::string logPath;
+    int fd;
+
+    std::mutex mutex;
+    std::condition_variable flushed;
+    std::string pending;        // records appended but not written yet
+    uint64_t lastSequence;      // of the last record appended
+    uint64_t durableSequence;   // of the last record known to be on disk
+    uint64_t logBytes;
+    bool flushing;
+    bool failed;
+
+    static void put32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out += (char)(value >> (8 * i));
+        }
+    }
+
+    static void put64(std::string& out, uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            out += (char)(value >> (8 * i));
+        }
+    }
+
+    static uint32_t get32(const char* p) {
+        uint32_t value = 0;
+        for (int i = 3; i >= 0; i--) {
+            value = value << 8 | (unsigned char)p[i];
+        }
+        return value;
+    }
+
+    static uint64_t get64(const char* p) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--) {
+            value = value << 8 | (unsigned char)p[i];
+        }
+        return value;
+    }
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += (char)(value | 0x80);
+            value >>= 7;
+        }
+        out += (char)value;
+    }
+
+    // false when the varint runs past end
+    static bool getVarint(const char*& p, const char* end, uint64_t* value) {
+        *value = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            unsigned char b = (unsigned char)*p++;
+            *value |= (uint64_t)(b & 0x7f) << shift;
+            if (b < 0x80) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void putString(std::string& out, const std::string& text) {
+        putVarint(out, text.size());
+        out += text;
+    }
+
+    static bool getString(const char*& p, const char* end, std::string* text) {
+        uint64_t size;
+        if (!getVarint(p, end, &size) || size > (uint64_t)(end - p)) {
+            return false;
+        }
+        text->assign(p, (size_t)size);
+        p += size;
+        return true;
+    }
+
+    static void putCourse(std::string& out, const Course& course) {
+        putString(out, course.courseNum);
+        putString(out, course.courseName);
+        putVarint(out, course.prereqs.size());
+        for (size_t i = 0; i < course.prereqs.size(); i++) {
+            putString(out, course.prereqs[i]);
+        }
+        putVarint(out, course.attributes.size());
+        for (size_t i = 0; i < course.attributes.size(); i++) {
+            putString(out, course.attributes[i]);
+        }
+    }
+
+    static bool getCourse(const char*& p, const char* end, Course* course) {
+        uint64_t count;
+        if (!getString(p, end, &course->courseNum) || !getString(p, end, &course->courseName)
+            || !getVarint(p, end, &count) || count > (uint64_t)(end - p)) {
+            return false;
+        }
+        course->prereqs.resize((size_t)count);
+        for (size_t i = 0; i < course->prereqs.size(); i++) {
+            if (!getString(p, end, &course->prereqs[i])) {
+                return false;
+            }
+        }
+        if (!getVarint(p, end, &count) || count > (uint64_t)(end - p)) {
+            return false;
+        }
+        course->attributes.resize((size_t)count);
+        for (size_t i = 0; i < course->attributes.size(); i++) {
+            if (!getString(p, end, &course->attributes[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // FNV-1a over a record or the snapshot body
+    static uint64_t checksum(const char* data, size_t len) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; i++) {
+            hash ^= (unsigned char)data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // one framed record: payload length, checksum, then sequence, op and course
+    static void putRecord(std::string& out, uint64_t sequence, JournalOp op, const Course& course) {
+        std::string payload;
+        put64(payload, sequence);
+        payload += (char)op;
+        if (op == JOURNAL_INSERT) {
+            putCourse(payload, course);
+        }
+        else {
+            putString(payload, course.courseNum);
+        }
+        put32(out, (uint32_t)payload.size());
+        put32(out, (uint32_t)checksum(payload.data(), payload.size()));
+        out += payload;
+    }
+
+    // the record at p, false when it is cut short or fails its checksum
+    static bool getRecord(const char*& p, const char* end, uint64_t* sequence, JournalOp* op, Course* course) {
+        if ((size_t)(end - p) < RECORD_HEADER) {
+            return false;
+        }
+        uint32_t size = get32(p);
+        uint32_t sum = get32(p + 4);
+        const char* payload = p + RECORD_HEADER;
+        if (size < 9 || size > (size_t)(end - payload) || sum != (uint32_t)checksum(payload, size)) {
+            return false;
+        }
+        const char* q = payload + 9;
+        const char* recordEnd = payload + size;
+        *sequence = get64(payload);
+        *op = (JournalOp)payload[8];
+        *course = Course();
+        bool ok = *op == JOURNAL_INSERT ? getCourse(q, recordEnd, course)
+            : *op == JOURNAL_REMOVE && getString(q, recordEnd, &course->courseNum);
+        if (!ok || q != recordEnd) {
+            return false;
+        }
+        p = recordEnd;
+        return true;
+    }
+
+#ifdef CATALOG_JOURNAL_POSIX
+    static bool writeAll(int out, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(out, data, len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= (size_t)n;
+        }
+        return true;
+    }
+
+    static bool readFile(const std::string& path, std::string* text, uint64_t from = 0) {
+        int in = ::open(path.c_str(), O_RDONLY);
+        if (in < 0) {
+            return false;
+        }
+        if (from > 0 && ::lseek(in, (off_t)from, SEEK_SET) < 0) {
+            ::close(in);
+            return false;
+        }
+        char buffer[64 * 1024];
+        ssize_t n;
+        while ((n = ::read(in, buffer, sizeof(buffer))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ::close(in);
+                return false;
+            }
+            text->append(buffer, (size_t)n);
+        }
+        ::close(in);
+        return true;
+    }
+
+    // write a whole file beside path, sync it and rename it over path, so
+    // path holds either the old bytes or all of the new ones
+    static bool replaceFile(const std::string& path, const std::string& bytes) {
+        std::string temporary = path + ".tmp";
+        int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) {
+            return false;
+        }
+        bool ok = writeAll(out, bytes.data(), bytes.size()) && ::fsync(out) == 0;
+        ok = ::close(out) == 0 && ok;
+        if (!ok || ::rename(temporary.c_str(), path.c_str()) != 0) {
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        syncDirectory(path);
+        return true;
+    }
+
+    // write the records of the log at path from byte *offset on that are
+    // newer than sequence to out; *offset moves past the last whole record
+    // read and *kept grows by the bytes written
+    static bool copyRecords(const std::string& path, int out, uint64_t sequence, uint64_t* offset, uint64_t* kept) {
+        std::string log;
+        if (!readFile(path, &log, *offset)) {
+            return false;
+        }
+        std::string newer;
+        const char* p = log.data();
+        const char* end = p + log.size();
+        const char* start = p;
+        uint64_t recordSequence;
+        JournalOp op;
+        Course course;
+        while (getRecord(p, end, &recordSequence, &op, &course)) {
+            if (recordSequence > sequence) {
+                newer.append(start, (size_t)(p - start));
+            }
+            start = p;
+        }
+        *offset += (uint64_t)(start - log.data());
+        *kept += newer.size();
+        return writeAll(out, newer.data(), newer.size());
+    }
+
+    // make a rename in the directory of path durable
+    static void syncDirectory(const std::string& path) {
+        size_t slash = path.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int dir = ::open(directory.c_str(), O_RDONLY);
+        if (dir >= 0) {
+            ::fsync(dir);
+            ::close(dir);
+        }
+    }
+#endif
+
+public:
+    CatalogJournal() {
+        fd = -1;
+        lastSequence = 0;
+        durableSequence = 0;
+        logBytes = 0;
+        flushing = false;
+        failed = false;
+    }
+
+    ~CatalogJournal() {
+        Close();
+    }
+
+    CatalogJournal(const CatalogJournal&) = delete;
+    CatalogJournal& operator=(const CatalogJournal&) = delete;
+
+    // Whether edits are being logged
+    bool IsOpen() const {
+        return fd >= 0;
+    }
+
+    // Bytes in the log file, records still waiting for Sync not counted
+    uint64_t LogBytes() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return logBytes;
+    }
+
+    // Sequence number of the last record appended
+    uint64_t LastSequence() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return lastSequence;
+    }
+
+    // Read back the snapshot and log at basePath.snap and basePath.log and
+    // open the log for appending
+    //
+    // insert(course) gets every snapshot course in key order, then apply(op,
+    // course) every newer log record in order; a removal only carries the
+    // course number. A corrupt snapshot is skipped and reported, a torn log
+    // tail is cut off. False when the log cannot be opened.
+    template <typename Insert, typename Apply>
+    bool Open(const std::string& basePath, Insert insert, Apply apply, JournalRecovery* recovery) {
+        Close();
+        memset(recovery, 0, sizeof(*recovery));
+        snapshotPath = basePath + ".snap";
+        logPath = basePath + ".log";
+#ifdef CATALOG_JOURNAL_POSIX
+        uint64_t snapshotSequence = 0;
+        int in = ::open(snapshotPath.c_str(), O_RDONLY);
+        struct stat status;
+        if (in >= 0 && ::fstat(in, &status) == 0 && (size_t)status.st_size >= SNAPSHOT_HEADER) {
+            // map the snapshot and decode straight out of the page cache
+            size_t size = (size_t)status.st_size;
+            void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, in, 0);
+            if (mapped != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+                ::madvise(mapped, size, MADV_SEQUENTIAL);
+#endif
+                const char* base = (const char*)mapped;
+                const char* p = base + SNAPSHOT_HEADER;
+                const char* end = base + size;
+                uint64_t count = get64(base + 16);
+                bool valid = get64(base) == SNAPSHOT_MAGIC && get64(base + 24) == (uint64_t)(end - p)
+                    && get64(base + 32) == checksum(p, (size_t)(end - p));
+                Course course;
+                for (uint64_t i = 0; valid && i < count; i++) {
+                    valid = getCourse(p, end, &course);
+                    if (valid) {
+                        insert(course);
+                        recovery->snapshotCourses++;
+                    }
+                }
+                if (valid) {
+                    snapshotSequence = get64(base + 8);
+                }
+                recovery->snapshotCorrupt = !valid;
+                ::munmap(mapped, size);
+            }
+        }
+        if (in >= 0) {
+            ::close(in);
+        }
+
+        std::string log;
+        readFile(logPath, &log);
+        const char* p = log.data();
+        const char* end = p + log.size();
+        uint64_t sequence = 0;
+        JournalOp op;
+        Course course;
+        lastSequence = snapshotSequence;
+        while (getRecord(p, end, &sequence, &op, &course)) {
+            if (sequence > snapshotSequence) {
+                apply(op, course);
+                recovery->replayed++;
+                lastSequence = sequence;
+            }
+        }
+        size_t good = (size_t)(p - log.data());
+        recovery->droppedBytes = log.size() - good;
+
+        fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        if (recovery->droppedBytes > 0 && ::ftruncate(fd, (off_t)good) != 0) {
+            Close();
+            return false;
+        }
+        durableSequence = lastSequence;
+        logBytes = good;
+        failed = false;
+        return true;
+#else
+        (void)insert;
+        (void)apply;
+        return false;
+#endif
+    }
+
+    // Stop logging; records not synced yet are dropped
+    void Close() {
+#ifdef CATALOG_JOURNAL_POSIX
+        std::unique_lock<std::mutex> guard(mutex);
+        while (flushing) {
+            flushed.wait(guard);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        pending.clear();
+#endif
+    }
+
+    // Queue an edit and return its sequence number, 0 when nothing is
+    // logged. Call it in the order the edits are applied.
+    uint64_t Append(JournalOp op, const Course& course) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (fd < 0) {
+            return 0;
+        }
+        lastSequence++;
+        putRecord(pending, lastSequence, op, course);
+        return lastSequence;
+    }
+
+    // Wait until the record with a sequence number and every one before it
+    // is on disk, flushing the queue if no other caller is. False when the
+    // log could not be written.
+    bool Sync(uint64_t sequence) {
+#ifdef CATALOG_JOURNAL_POSIX
+        std::unique_lock<std::mutex> guard(mutex);
+        while (durableSequence < sequence) {
+            if (failed || fd < 0) {
+                return false;
+            }
+            if (flushing) {
+                flushed.wait(guard);
+                continue;
+            }
+            // write everything queued, records appended meanwhile go next time
+            flushing = true;
+            std::string batch;
+            batch.swap(pending);
+            uint64_t through = lastSequence;
+            guard.unlock();
+            bool ok = writeAll(fd, batch.data(), batch.size()) && ::fdatasync(fd) == 0;
+            guard.lock();
+            flushing = false;
+            if (ok) {
+                durableSequence = through;
+                logBytes += batch.size();
+            }
+            else {
+                failed = true;
+            }
+            flushed.notify_all();
+        }
+        return true;
+#else
+        return sequence == 0;
+#endif
+    }
+
+    // Encode every course of a tree as a snapshot through a sequence number.
+    // The caller holds whatever keeps the tree and the number in step.
+    template <typename Tree>
+    static std::string EncodeSnapshot(const Tree& tree, uint64_t sequence) {
+        std::string image(SNAPSHOT_HEADER, '\0');
+        uint64_t count = 0;
+        tree.InOrder([&](const Course& course) {
+            putCourse(image, course);
+            count++;
+        });
+        std::string header;
+        put64(header, SNAPSHOT_MAGIC);
+        put64(header, sequence);
+        put64(header, count);
+        put64(header, image.size() - SNAPSHOT_HEADER);
+        put64(header, checksum(image.data() + SNAPSHOT_HEADER, image.size() - SNAPSHOT_HEADER));
+        image.replace(0, SNAPSHOT_HEADER, header);
+        return image;
+    }
+
+    // Make an encoded snapshot the one a restart reads, then drop the log
+    // records it covers
+    //
+    // The records after the snapshot are copied to a new log beside the old
+    // one while appends and syncs go on. Then syncs are held back, as during
+    // a flush, while the records synced meanwhile are copied and the new log
+    // is synced and renamed into place; appends only ever wait for the
+    // mutex, which is not held across any file work.
+    bool Compact(const std::string& image, uint64_t sequence) {
+#ifdef CATALOG_JOURNAL_POSIX
+        if (fd < 0 || !replaceFile(snapshotPath, image)) {
+            return false;
+        }
+        std::string temporary = logPath + ".tmp";
+        int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) {
+            return false;
+        }
+        uint64_t copied = 0;
+        uint64_t kept = 0;
+        bool ok = copyRecords(logPath, out, sequence, &copied, &kept);
+
+        std::unique_lock<std::mutex> guard(mutex);
+        while (flushing) {
+            flushed.wait(guard);
+        }
+        flushing = true;
+        uint64_t written = logBytes;
+        guard.unlock();
+
+        // nothing writes the old log now, so every record in it is whole
+        ok = ok && copyRecords(logPath, out, sequence, &copied, &kept) && copied == written
+            && ::fsync(out) == 0;
+        ok = ::close(out) == 0 && ok;
+        bool renamed = ok && ::rename(temporary.c_str(), logPath.c_str()) == 0;
+        int reopened = -1;
+        if (renamed) {
+            syncDirectory(logPath);
+            reopened = ::open(logPath.c_str(), O_WRONLY | O_APPEND);
+        }
+        else {
+            ::unlink(temporary.c_str());
+        }
+
+        guard.lock();
+        flushing = false;
+        if (reopened >= 0) {
+            ::close(fd);
+            fd = reopened;
+            logBytes = kept;
+        }
+        else if (renamed) {
+            // the old log is gone and the new one cannot be appended to
+            failed = true;
+        }
+        flushed.notify_all();
+        return reopened >= 0;
+#else
+        (void)image;
+        (void)sequence;
+        return false;
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,291 @@
+//============================================================================
+// Name        : CatalogLoadGen.cpp
+// Author      : Paul Velazquez
+//
+// Load generator for the catalog server. Opens several connections, keeps
+// a fixed number of requests in flight on each and prints throughput and
+// latency percentiles as JSON.
+//
+//   g++ -O2 -std=c++17 -pthread CatalogLoadGen.cpp -o CatalogLoadGen
+//   ./BinarySearchTree --serve /tmp/catalog.sock courses.csv &
+//   ./CatalogLoadGen [--socket /tmp/catalog.sock] [--connections 4] [--pipeline 32]
+//                    [--requests 200000] [--seed 42]
+//============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CatalogProtocol.hpp"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+typedef chrono::steady_clock Clock;
+
+// A blocking connection to the server
+struct Client {
+    int fd;
+    string in;
+
+    Client() {
+        fd = -1;
+    }
+
+    ~Client() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool Connect(const string& path) {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        strcpy(address.sun_path, path.c_str());
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        return fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) == 0;
+    }
+
+    bool Send(const string& frames) {
+        size_t sent = 0;
+        while (sent < frames.size()) {
+            ssize_t n = send(fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += (size_t)n;
+        }
+        return true;
+    }
+
+    // wait for more bytes, false when the server went away
+    bool Receive() {
+        char buffer[64 * 1024];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return false;
+        }
+        in.append(buffer, (size_t)n);
+        return true;
+    }
+};
+
+// a request picked from the mix: mostly lookups, some ranges and prerequisites
+CatalogRequest makeRequest(const vector<string>& keys, mt19937_64& random, uint32_t id) {
+    CatalogRequest request;
+    request.id = id;
+    size_t at = random() % keys.size();
+    int kind = (int)(random() % 100);
+    if (kind < 90) {
+        request.op = OP_LOOKUP;
+        request.key = keys[at];
+    }
+    else if (kind < 95) {
+        request.op = OP_RANGE;
+        request.key = keys[at];
+        request.high = keys[min(at + 10, keys.size() - 1)];
+    }
+    else {
+        request.op = OP_PREREQS;
+        request.key = keys[at];
+    }
+    return request;
+}
+
+// what one connection measured
+struct Results {
+    vector<double> latencies;   // microseconds
+    size_t errors;
+};
+
+// run count requests on one connection with pipeline of them in flight
+void drive(const string& path, const vector<string>& keys, size_t count, size_t pipeline, uint64_t seed, Results* results) {
+    results->errors = 0;
+    Client client;
+    if (!client.Connect(path)) {
+        results->errors = count;
+        return;
+    }
+    mt19937_64 random(seed);
+    vector<Clock::time_point> sentAt(count);
+    size_t issued = 0;
+    size_t done = 0;
+
+    string frames;
+    while (issued < count && issued < pipeline) {
+        encodeRequest(frames, makeRequest(keys, random, (uint32_t)issued));
+        sentAt[issued] = Clock::now();
+        issued++;
+    }
+    if (!client.Send(frames)) {
+        results->errors = count;
+        return;
+    }
+
+    while (done < count) {
+        if (!client.Receive()) {
+            results->errors += count - done;
+            return;
+        }
+        // every response lets one more request go out
+        size_t at = 0;
+        uint32_t id;
+        CatalogResponse response;
+        frames.clear();
+        while (decodeResponse(client.in, at, &id, &response)) {
+            Clock::time_point now = Clock::now();
+            results->latencies.push_back(chrono::duration<double, micro>(now - sentAt[id]).count());
+            if (response.status == STATUS_BAD_REQUEST) {
+                results->errors++;
+            }
+            done++;
+            if (issued < count) {
+                encodeRequest(frames, makeRequest(keys, random, (uint32_t)issued));
+                sentAt[issued] = now;
+                issued++;
+            }
+        }
+        client.in.erase(0, at);
+        if (!frames.empty() && !client.Send(frames)) {
+            results->errors += count - done;
+            return;
+        }
+    }
+}
+
+// every course number in the catalog, from one RANGE request
+bool fetchKeys(const string& path, vector<string>* keys) {
+    Client client;
+    if (!client.Connect(path)) {
+        return false;
+    }
+    CatalogRequest request;
+    request.id = 0;
+    request.op = OP_RANGE;
+    request.high = string(1, '\xff');
+    string frame;
+    encodeRequest(frame, request);
+    if (!client.Send(frame)) {
+        return false;
+    }
+    size_t at = 0;
+    uint32_t id;
+    CatalogResponse response;
+    while (!decodeResponse(client.in, at, &id, &response)) {
+        if (!client.Receive()) {
+            return false;
+        }
+    }
+    size_t start = 0;
+    for (size_t end = response.body.find('\n'); end != string::npos; end = response.body.find('\n', start)) {
+        keys->push_back(response.body.substr(start, end - start));
+        start = end + 1;
+    }
+    return true;
+}
+
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t at = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[at];
+}
+
+int main(int argc, char* argv[]) {
+    string path = "/tmp/catalog.sock";
+    size_t connections = 4;
+    size_t pipeline = 32;
+    size_t requests = 200000;
+    uint64_t seed = 42;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--socket") == 0) {
+            path = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--connections") == 0) {
+            connections = max<size_t>(1, strtoull(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = max<size_t>(1, strtoull(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--requests") == 0) {
+            requests = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[i + 1], nullptr, 10);
+        }
+        else {
+            cerr << "unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    vector<string> keys;
+    if (!fetchKeys(path, &keys)) {
+        cerr << "could not query " << path << endl;
+        return 1;
+    }
+    if (keys.empty()) {
+        cerr << "the catalog on " << path << " is empty" << endl;
+        return 1;
+    }
+
+    vector<Results> results(connections);
+    vector<thread> threads;
+    Clock::time_point start = Clock::now();
+    for (size_t c = 0; c < connections; c++) {
+        size_t count = requests / connections + (c < requests % connections ? 1 : 0);
+        threads.emplace_back(drive, path, cref(keys), count, pipeline, seed + c, &results[c]);
+    }
+    for (size_t c = 0; c < threads.size(); c++) {
+        threads[c].join();
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    vector<double> latencies;
+    size_t errors = 0;
+    for (size_t c = 0; c < results.size(); c++) {
+        latencies.insert(latencies.end(), results[c].latencies.begin(), results[c].latencies.end());
+        errors += results[c].errors;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    cout << "{\n  \"benchmark\": \"server\",\n  \"courses\": " << keys.size()
+        << ",\n  \"connections\": " << connections << ",\n  \"pipeline\": " << pipeline
+        << ",\n  \"requests\": " << latencies.size() << ",\n  \"errors\": " << errors
+        << ",\n  \"seconds\": " << seconds << ",\n  \"qps\": " << latencies.size() / seconds
+        << ",\n  \"latency_us\": { \"p50\": " << percentile(latencies, 0.5)
+        << ", \"p90\": " << percentile(latencies, 0.9) << ", \"p99\": " << percentile(latencies, 0.99)
+        << ", \"p999\": " << percentile(latencies, 0.999)
+        << ", \"max\": " << (latencies.empty() ? 0 : latencies.back()) << " }\n}" << endl;
+
+    return 0;
+}
+
+#else
+
+int main() {
+    cerr << "CatalogLoadGen needs Linux." << endl;
+    return 1;
+}
+
+#endif
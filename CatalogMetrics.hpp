@@ -0,0 +1,187 @@
+//============================================================================
+// Name        : CatalogMetrics.hpp
+// Author      : Paul Velazquez
+//
+// Hot path counters for the catalog. Build with -DCATALOG_METRICS to turn
+// them on, otherwise every CATALOG_METRIC / CATALOG_TIME compiles to nothing.
+//============================================================================
+
+#ifndef CATALOG_METRICS_HPP
+#define CATALOG_METRICS_HPP
+
+#include <cstdint>
+#include <iostream>
+
+#ifdef CATALOG_METRICS
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// every counter the catalog keeps, one set per thread
+#define CATALOG_METRIC_FIELDS(X) \
+    X(searches) \
+    X(searchComparisons) \
+    X(searchDepth) \
+    X(inserts) \
+    X(insertComparisons) \
+    X(removes) \
+    X(removeComparisons) \
+    X(bytesAllocated) \
+    X(bytesFreed) \
+    X(parseNanos) \
+    X(buildNanos) \
+    X(indexNanos) \
+    X(cacheHits) \
+    X(cacheMisses) \
+    X(filterRejects)
+
+// A plain snapshot of the counters
+struct MetricTotals {
+#define CATALOG_METRIC_TOTAL(name) uint64_t name = 0;
+    CATALOG_METRIC_FIELDS(CATALOG_METRIC_TOTAL)
+#undef CATALOG_METRIC_TOTAL
+};
+
+// Counters owned by one thread
+//
+// Only the owning thread writes, so an add is a relaxed load and store with
+// no locked instruction. Other threads may read at any time to aggregate.
+struct MetricCounters {
+#define CATALOG_METRIC_COUNTER(name) std::atomic<uint64_t> name{ 0 };
+    CATALOG_METRIC_FIELDS(CATALOG_METRIC_COUNTER)
+#undef CATALOG_METRIC_COUNTER
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void addTo(MetricTotals& totals) const {
+#define CATALOG_METRIC_SUM(name) totals.name += name.load(std::memory_order_relaxed);
+        CATALOG_METRIC_FIELDS(CATALOG_METRIC_SUM)
+#undef CATALOG_METRIC_SUM
+    }
+};
+
+// All live per thread counters plus what exited threads left behind
+class MetricRegistry {
+
+private:
+    std::mutex lock;
+    std::vector<MetricCounters*> threads;
+    MetricTotals retired;
+
+public:
+    static MetricRegistry& instance() {
+        static MetricRegistry registry;
+        return registry;
+    }
+
+    void attach(MetricCounters* counters) {
+        std::lock_guard<std::mutex> guard(lock);
+        threads.push_back(counters);
+    }
+
+    // fold a finished thread's counters into the retired totals
+    void detach(MetricCounters* counters) {
+        std::lock_guard<std::mutex> guard(lock);
+        counters->addTo(retired);
+        for (size_t i = 0; i < threads.size(); i++) {
+            if (threads[i] == counters) {
+                threads[i] = threads.back();
+                threads.pop_back();
+                break;
+            }
+        }
+    }
+
+    // Sum of every thread, live and finished
+    MetricTotals Aggregate() {
+        std::lock_guard<std::mutex> guard(lock);
+        MetricTotals totals = retired;
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i]->addTo(totals);
+        }
+        return totals;
+    }
+};
+
+// registers itself on first use in a thread and retires on thread exit
+struct ThreadMetrics {
+    MetricCounters counters;
+
+    ThreadMetrics() {
+        MetricRegistry::instance().attach(&counters);
+    }
+
+    ~ThreadMetrics() {
+        MetricRegistry::instance().detach(&counters);
+    }
+};
+
+inline MetricCounters& threadMetrics() {
+    thread_local ThreadMetrics metrics;
+    return metrics.counters;
+}
+
+// Adds the time spent in a scope to one counter
+class MetricTimer {
+
+private:
+    std::atomic<uint64_t> MetricCounters::* field;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    MetricTimer(std::atomic<uint64_t> MetricCounters::* aField) {
+        field = aField;
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~MetricTimer() {
+        uint64_t nanos = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        MetricCounters::add(threadMetrics().*field, nanos);
+    }
+};
+
+#define CATALOG_METRIC(name, n) MetricCounters::add(threadMetrics().name, (uint64_t)(n))
+#define CATALOG_TIME_CONCAT(a, b) a##b
+#define CATALOG_TIME_NAME(line) CATALOG_TIME_CONCAT(metricTimer, line)
+#define CATALOG_TIME(name) MetricTimer CATALOG_TIME_NAME(__LINE__)(&MetricCounters::name)
+
+// Print the aggregated counters
+inline void dumpMetrics(std::ostream& out) {
+    MetricTotals totals = MetricRegistry::instance().Aggregate();
+    uint64_t searches = totals.searches > 0 ? totals.searches : 1;
+    uint64_t inserts = totals.inserts > 0 ? totals.inserts : 1;
+    uint64_t removes = totals.removes > 0 ? totals.removes : 1;
+    out << "Searches: " << totals.searches
+        << " (" << (double)totals.searchComparisons / searches << " comparisons, "
+        << (double)totals.searchDepth / searches << " levels each)" << std::endl;
+    out << "Inserts: " << totals.inserts
+        << " (" << (double)totals.insertComparisons / inserts << " comparisons each)" << std::endl;
+    out << "Removes: " << totals.removes
+        << " (" << (double)totals.removeComparisons / removes << " comparisons each)" << std::endl;
+    out << "Node bytes: " << totals.bytesAllocated - totals.bytesFreed << " live, "
+        << totals.bytesAllocated << " allocated" << std::endl;
+    uint64_t lookups = totals.cacheHits + totals.cacheMisses > 0 ? totals.cacheHits + totals.cacheMisses : 1;
+    out << "Display cache: " << totals.cacheHits << " hits, " << totals.cacheMisses << " misses ("
+        << 100.0 * totals.cacheHits / lookups << "% hit rate)" << std::endl;
+    out << "Key filter: " << totals.filterRejects << " lookups turned away" << std::endl;
+    out << "Load phases: parse " << totals.parseNanos / 1e6 << " ms, build "
+        << totals.buildNanos / 1e6 << " ms, index " << totals.indexNanos / 1e6 << " ms" << std::endl;
+}
+
+#else
+
+#define CATALOG_METRIC(name, n) ((void)(n))
+#define CATALOG_TIME(name) ((void)0)
+
+inline void dumpMetrics(std::ostream& out) {
+    out << "Metrics are off, rebuild with -DCATALOG_METRICS to collect them." << std::endl;
+}
+
+#endif
+
+#endif
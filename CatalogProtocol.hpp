@@ -0,0 +1,147 @@
+//============================================================================
+// Name        : CatalogProtocol.hpp
+// Author      : Paul Velazquez
+//
+// Wire format of the catalog server. Every message is a frame: a 32 bit
+// little endian length followed by that many bytes.
+//
+//   request:  u32 id, u8 op, arguments
+//   response: u32 id, u8 status, body
+//
+// LOOKUP, PREREQS and DEPENDENTS take a course number as their argument;
+// RANGE takes a u16 length, the low course number, then the high one. A
+// client may send any number of requests without waiting; responses come
+// back on the same connection in request order and carry the request's id.
+//============================================================================
+
+#ifndef CATALOG_PROTOCOL_HPP
+#define CATALOG_PROTOCOL_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum CatalogOp : uint8_t {
+    OP_LOOKUP = 1,  // formatted course, as Find Course shows it
+    OP_RANGE = 2,   // course numbers from low to high, one per line
+    OP_PREREQS = 3, // every prerequisite of a course, direct or not, one per line
+    OP_DEPENDENTS = 4   // every course needing a course, direct or not, one per line
+};
+
+enum CatalogStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_NOT_FOUND = 1,
+    STATUS_BAD_REQUEST = 2
+};
+
+// frames larger than this close the connection
+const uint32_t MAX_FRAME = 1 << 20;
+
+struct CatalogRequest {
+    uint32_t id;
+    uint8_t op;
+    std::string key;
+    std::string high;   // RANGE only
+};
+
+struct CatalogResponse {
+    uint8_t status;
+    std::string body;
+};
+
+inline void putU32(std::string& out, uint32_t value) {
+    char bytes[4] = { (char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24) };
+    out.append(bytes, 4);
+}
+
+inline uint32_t getU32(const char* p) {
+    return (uint32_t)(unsigned char)p[0] | (uint32_t)(unsigned char)p[1] << 8
+        | (uint32_t)(unsigned char)p[2] << 16 | (uint32_t)(unsigned char)p[3] << 24;
+}
+
+// Append one request frame
+inline void encodeRequest(std::string& out, const CatalogRequest& request) {
+    uint32_t length = 5 + (uint32_t)request.key.size();
+    if (request.op == OP_RANGE) {
+        length += 2 + (uint32_t)request.high.size();
+    }
+    putU32(out, length);
+    putU32(out, request.id);
+    out.push_back((char)request.op);
+    if (request.op == OP_RANGE) {
+        out.push_back((char)request.key.size());
+        out.push_back((char)(request.key.size() >> 8));
+        out += request.key;
+        out += request.high;
+    }
+    else {
+        out += request.key;
+    }
+}
+
+// Append one response frame
+inline void encodeResponse(std::string& out, uint32_t id, const CatalogResponse& response) {
+    putU32(out, 5 + (uint32_t)response.body.size());
+    putU32(out, id);
+    out.push_back((char)response.status);
+    out += response.body;
+}
+
+// Take the complete request frames off the front of a buffer, at most limit.
+// Returns false when a frame is malformed or too large.
+inline bool decodeRequests(std::string& buffer, std::vector<CatalogRequest>& requests, size_t limit = SIZE_MAX) {
+    size_t at = 0;
+    bool ok = true;
+    while (buffer.size() - at >= 4 && requests.size() < limit) {
+        uint32_t length = getU32(buffer.data() + at);
+        if (length < 5 || length > MAX_FRAME) {
+            ok = false;
+            break;
+        }
+        if (buffer.size() - at - 4 < length) {
+            break;
+        }
+        const char* p = buffer.data() + at + 4;
+        CatalogRequest request;
+        request.id = getU32(p);
+        request.op = (uint8_t)p[4];
+        const char* args = p + 5;
+        size_t argsLen = length - 5;
+        if (request.op == OP_RANGE) {
+            size_t lowLen = argsLen >= 2 ? ((size_t)(unsigned char)args[0] | (size_t)(unsigned char)args[1] << 8) : 0;
+            if (argsLen < 2 || argsLen - 2 < lowLen) {
+                ok = false;
+                break;
+            }
+            request.key.assign(args + 2, lowLen);
+            request.high.assign(args + 2 + lowLen, argsLen - 2 - lowLen);
+        }
+        else {
+            request.key.assign(args, argsLen);
+        }
+        requests.push_back(request);
+        at += 4 + length;
+    }
+    buffer.erase(0, at);
+    return ok;
+}
+
+// Take one complete response frame off the front of a buffer, false when
+// none is complete yet
+inline bool decodeResponse(std::string& buffer, size_t& at, uint32_t* id, CatalogResponse* response) {
+    if (buffer.size() - at < 4) {
+        return false;
+    }
+    uint32_t length = getU32(buffer.data() + at);
+    if (length < 5 || buffer.size() - at - 4 < length) {
+        return false;
+    }
+    const char* p = buffer.data() + at + 4;
+    *id = getU32(p);
+    response->status = (uint8_t)p[4];
+    response->body.assign(p + 5, length - 5);
+    at += 4 + length;
+    return true;
+}
+
+#endif
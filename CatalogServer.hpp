@@ -0,0 +1,409 @@
+//============================================================================
+// Name        : CatalogServer.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef CATALOG_SERVER_HPP
+#define CATALOG_SERVER_HPP
+
+#ifdef __linux__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "CatalogProtocol.hpp"
+
+// Catalog queries served over a Unix domain socket
+//
+// One thread runs an epoll loop that accepts connections, reads request
+// frames and writes responses, all non-blocking. The complete frames a
+// read delivers, up to MAX_BATCH of them, go to the worker pool as one
+// batch, answered by the handler in a single call; a connection has at
+// most one batch in flight, so its responses stay in request order and
+// later requests queue up in its read buffer. Workers hand finished
+// batches back through an eventfd.
+//
+// A connection is not read while its batch is out or while MAX_BUFFERED
+// bytes of responses wait for it, so a client that sends without reading
+// fills its own socket buffer instead of the server's memory. A batch
+// holds at most MAX_BATCH requests, which bounds how far one batch can go
+// past the cap; a connection whose unsent output still passes MAX_UNSENT
+// is closed.
+//
+// A client that shuts down its writing side still gets its answers: the
+// connection stops being read, the requests already read are answered
+// and sent, and only then is it closed.
+class CatalogServer {
+
+public:
+    typedef std::function<void(const std::vector<CatalogRequest>&, std::vector<CatalogResponse>&)> Handler;
+
+private:
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        size_t sent;
+        bool busy;          // a batch of this connection is with the workers
+        bool ended;         // the client sent everything it will send
+        uint32_t events;    // what epoll is watching for
+    };
+
+    struct Batch {
+        uint64_t connection;
+        std::vector<CatalogRequest> requests;
+        std::string responses;
+    };
+
+    // epoll tags of the two fds that are not connections
+    static const uint64_t LISTENER = 0;
+    static const uint64_t WAKE = 1;
+    // most input read ahead and output left unsent per connection before
+    // it stops being read
+    static const size_t MAX_BUFFERED = 4 * MAX_FRAME;
+    static const size_t MAX_BATCH = 64;
+    static const size_t MAX_UNSENT = 16 * MAX_BUFFERED;
+
+    Handler handler;
+    std::string path;
+    int listener;
+    int epoll;
+    int wake;
+    std::atomic<bool> stopping;
+    uint64_t nextConnection;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<Batch> queued;
+    std::deque<Batch> finished;
+
+    void signalWake() {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    void work() {
+        while (true) {
+            Batch batch;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [this]() { return stopping || !queued.empty(); });
+                if (queued.empty()) {
+                    return;
+                }
+                batch = std::move(queued.front());
+                queued.pop_front();
+            }
+            std::vector<CatalogResponse> responses(batch.requests.size());
+            handler(batch.requests, responses);
+            for (size_t i = 0; i < responses.size(); i++) {
+                encodeResponse(batch.responses, batch.requests[i].id, responses[i]);
+            }
+            batch.requests.clear();
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                finished.push_back(std::move(batch));
+            }
+            signalWake();
+        }
+    }
+
+    void watch(int fd, uint64_t tag, uint32_t events, int op) {
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.u64 = tag;
+        epoll_ctl(epoll, op, fd, &event);
+    }
+
+    void close(uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) {
+            return;
+        }
+        epoll_ctl(epoll, EPOLL_CTL_DEL, found->second->fd, nullptr);
+        ::close(found->second->fd);
+        connections.erase(found);
+    }
+
+    void accept() {
+        while (true) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            uint64_t id = nextConnection++;
+            std::unique_ptr<Connection> connection(new Connection());
+            connection->fd = fd;
+            connection->sent = 0;
+            connection->busy = false;
+            connection->ended = false;
+            connection->events = EPOLLIN | EPOLLRDHUP;
+            connections[id] = std::move(connection);
+            watch(fd, id, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+        }
+    }
+
+    // send what the socket takes, false when the connection broke
+    bool flush(Connection& connection) {
+        while (connection.sent < connection.out.size()) {
+            ssize_t n = ::send(connection.fd, connection.out.data() + connection.sent,
+                connection.out.size() - connection.sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                break;
+            }
+            connection.sent += (size_t)n;
+        }
+        if (connection.sent == connection.out.size()) {
+            connection.out.clear();
+            connection.sent = 0;
+        }
+        return true;
+    }
+
+    // read only when a new batch could go out, write while output waits
+    void rearm(uint64_t id, Connection& connection) {
+        uint32_t events = 0;
+        if (!connection.ended && !connection.busy && connection.out.size() < MAX_BUFFERED) {
+            events |= EPOLLIN | EPOLLRDHUP;
+        }
+        if (!connection.out.empty()) {
+            events |= EPOLLOUT;
+        }
+        if (events != connection.events) {
+            connection.events = events;
+            watch(connection.fd, id, events, EPOLL_CTL_MOD);
+        }
+    }
+
+    // hand up to MAX_BATCH complete frames to the workers, false on a bad frame
+    bool dispatch(uint64_t id, Connection& connection) {
+        if (connection.busy || connection.out.size() >= MAX_BUFFERED) {
+            return true;
+        }
+        Batch batch;
+        batch.connection = id;
+        bool ok = decodeRequests(connection.in, batch.requests, MAX_BATCH);
+        if (!batch.requests.empty()) {
+            connection.busy = true;
+            std::lock_guard<std::mutex> guard(lock);
+            queued.push_back(std::move(batch));
+            ready.notify_one();
+        }
+        return ok;
+    }
+
+    // send, start the next batch and watch for what comes next; false when
+    // the connection broke, sent a bad frame, fell too far behind or ended
+    // with every answer sent
+    bool advance(uint64_t id, Connection& connection) {
+        if (!flush(connection) || connection.out.size() - connection.sent > MAX_UNSENT) {
+            return false;
+        }
+        if (!dispatch(id, connection)) {
+            return false;
+        }
+        if (connection.ended && !connection.busy && connection.out.empty()) {
+            // anything left in the read buffer is a frame that never finished
+            return false;
+        }
+        rearm(id, connection);
+        return true;
+    }
+
+    void receive(uint64_t id, Connection& connection) {
+        char buffer[64 * 1024];
+        // leave the rest in the socket once enough is read ahead
+        while (connection.in.size() < MAX_BUFFERED) {
+            ssize_t n = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                connection.in.append(buffer, (size_t)n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n == 0) {
+                // the client is done sending, answer what it sent
+                connection.ended = true;
+                break;
+            }
+            close(id);
+            return;
+        }
+        if (!advance(id, connection)) {
+            close(id);
+        }
+    }
+
+    // deliver batches the workers have answered
+    void collect() {
+        uint64_t count;
+        ssize_t ignored = ::read(wake, &count, sizeof(count));
+        (void)ignored;
+        std::deque<Batch> done;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            done.swap(finished);
+        }
+        for (size_t i = 0; i < done.size(); i++) {
+            auto found = connections.find(done[i].connection);
+            if (found == connections.end()) {
+                continue;
+            }
+            Connection& connection = *found->second;
+            connection.busy = false;
+            connection.out += done[i].responses;
+            if (!advance(done[i].connection, connection)) {
+                close(done[i].connection);
+            }
+        }
+    }
+
+public:
+    explicit CatalogServer(Handler aHandler, unsigned workerCount = std::thread::hardware_concurrency())
+        : stopping(false) {
+        handler = aHandler;
+        listener = -1;
+        epoll = -1;
+        wake = -1;
+        nextConnection = 2;
+        workerCount = workerCount > 0 ? workerCount : 1;
+        for (unsigned i = 0; i < workerCount; i++) {
+            workers.emplace_back(&CatalogServer::work, this);
+        }
+    }
+
+    ~CatalogServer() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+        while (!connections.empty()) {
+            close(connections.begin()->first);
+        }
+        if (listener >= 0) {
+            ::close(listener);
+            unlink(path.c_str());
+        }
+        if (epoll >= 0) {
+            ::close(epoll);
+        }
+        if (wake >= 0) {
+            ::close(wake);
+        }
+    }
+
+    CatalogServer(const CatalogServer&) = delete;
+    CatalogServer& operator=(const CatalogServer&) = delete;
+
+    // Bind the socket, replacing a stale one left at the path
+    bool Listen(const std::string& socketPath) {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        strcpy(address.sun_path, socketPath.c_str());
+        unlink(socketPath.c_str());
+
+        listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 128) != 0) {
+            return false;
+        }
+        path = socketPath;
+        epoll = epoll_create1(EPOLL_CLOEXEC);
+        wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll < 0 || wake < 0) {
+            return false;
+        }
+        watch(listener, LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+        watch(wake, WAKE, EPOLLIN, EPOLL_CTL_ADD);
+        return true;
+    }
+
+    // Serve until Stop is called
+    void Run() {
+        epoll_event events[64];
+        while (!stopping) {
+            int n = epoll_wait(epoll, events, 64, -1);
+            for (int i = 0; i < n; i++) {
+                uint64_t tag = events[i].data.u64;
+                if (tag == LISTENER) {
+                    accept();
+                    continue;
+                }
+                if (tag == WAKE) {
+                    collect();
+                    continue;
+                }
+                auto found = connections.find(tag);
+                if (found == connections.end()) {
+                    continue;
+                }
+                Connection& connection = *found->second;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    // gone both ways, nobody is left to read the responses;
+                    // a client that only stopped sending shows up as
+                    // EPOLLRDHUP and is read to the end below
+                    close(tag);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    if (!advance(tag, connection)) {
+                        close(tag);
+                        continue;
+                    }
+                }
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                    receive(tag, connection);
+                }
+            }
+        }
+    }
+
+    // Make Run return; only touches an atomic and the eventfd, so a signal
+    // handler may call it
+    void Stop() {
+        stopping = true;
+        signalWake();
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+//============================================================================
+// Name        : CatalogTree.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef CATALOG_TREE_HPP
+#define CATALOG_TREE_HPP
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Course.hpp"
+#include "MultiIndexCatalog.hpp"
+#include "RadixTree.hpp"
+
+// The course tree the program runs on, picked when it starts
+//
+// The menu, the loader and the server only use the operations below, so
+// any tree with the SearchTree interface can sit behind it.
+class CatalogTree {
+
+public:
+    typedef std::function<void(const Course&)> Visit;
+
+    virtual ~CatalogTree() {
+    }
+
+    virtual const char* Name() const = 0;
+    virtual size_t Size() const = 0;
+    virtual TreeShape Shape() const = 0;
+    virtual void Rebalance() = 0;
+    virtual void Insert(const Course& course) = 0;
+    virtual void Remove(const std::string& courseNum) = 0;
+    virtual void InsertBatch(const std::vector<Course>& courses) = 0;
+    virtual void RemoveBatch(const std::vector<std::string>& courseNums) = 0;
+    virtual const Course* Find(const std::string& courseNum) const = 0;
+    virtual void InOrder(const Visit& visit) const = 0;
+    virtual void Range(const std::string& lo, const std::string& hi, const Visit& visit) const = 0;
+
+    // Visit every course in name order, ties in key order; trees without a
+    // name index copy the courses out and sort them
+    virtual void ByName(const Visit& visit) const {
+        std::vector<const Course*> courses;
+        InOrder([&courses](const Course& course) {
+            courses.push_back(&course);
+        });
+        sortByName(courses);
+        for (size_t i = 0; i < courses.size(); i++) {
+            visit(*courses[i]);
+        }
+    }
+
+    // Visit the courses of one department, "CSCI" for CSCI200, in name order
+    virtual void InDepartment(const std::string& department, const Visit& visit) const {
+        // a department's course numbers start with it, followed by anything
+        // but another letter
+        std::vector<const Course*> courses;
+        Range(department, department + '\xff', [&courses, &department](const Course& course) {
+            if (departmentOf(course.courseNum) == department) {
+                courses.push_back(&course);
+            }
+        });
+        sortByName(courses);
+        for (size_t i = 0; i < courses.size(); i++) {
+            visit(*courses[i]);
+        }
+    }
+
+    // Print every course in key order with displayRow
+    void InOrder() const {
+        InOrder([](const Course& course) {
+            displayRow(course);
+        });
+    }
+
+protected:
+    // courses in key order into name order, the key order kept for equal names
+    static void sortByName(std::vector<const Course*>& courses) {
+        std::stable_sort(courses.begin(), courses.end(), [](const Course* a, const Course* b) {
+            return a->courseName < b->courseName;
+        });
+    }
+};
+
+// Whether a tree has its own InsertBatch and RemoveBatch
+template <typename Tree, typename = void>
+struct HasBatch : std::false_type {
+};
+
+template <typename Tree>
+struct HasBatch<Tree, std::void_t<decltype(std::declval<Tree&>().InsertBatch(std::vector<Course>()))>>
+    : std::true_type {
+};
+
+// Whether a tree keeps name and department orders of its own
+template <typename Tree, typename = void>
+struct HasNameOrder : std::false_type {
+};
+
+template <typename Tree>
+struct HasNameOrder<Tree, std::void_t<decltype(std::declval<const Tree&>().ByName(CatalogTree::Visit()))>>
+    : std::true_type {
+};
+
+// A CatalogTree over any tree with the SearchTree interface; trees without
+// batch operations get one Insert or Remove per course, trees without a
+// name order the sorted copy of CatalogTree
+template <typename Tree>
+class CatalogTreeOf : public CatalogTree {
+
+private:
+    const char* name;
+    Tree tree;
+
+public:
+    explicit CatalogTreeOf(const char* aName) {
+        name = aName;
+    }
+
+    using CatalogTree::InOrder;
+
+    const char* Name() const override {
+        return name;
+    }
+
+    size_t Size() const override {
+        return tree.Size();
+    }
+
+    TreeShape Shape() const override {
+        return tree.Shape();
+    }
+
+    void Rebalance() override {
+        tree.Rebalance();
+    }
+
+    void Insert(const Course& course) override {
+        tree.Insert(course);
+    }
+
+    void Remove(const std::string& courseNum) override {
+        tree.Remove(courseNum);
+    }
+
+    void InsertBatch(const std::vector<Course>& courses) override {
+        if constexpr (HasBatch<Tree>::value) {
+            tree.InsertBatch(courses);
+        }
+        else {
+            for (size_t i = 0; i < courses.size(); i++) {
+                tree.Insert(courses[i]);
+            }
+        }
+    }
+
+    void RemoveBatch(const std::vector<std::string>& courseNums) override {
+        if constexpr (HasBatch<Tree>::value) {
+            tree.RemoveBatch(courseNums);
+        }
+        else {
+            for (size_t i = 0; i < courseNums.size(); i++) {
+                tree.Remove(courseNums[i]);
+            }
+        }
+    }
+
+    const Course* Find(const std::string& courseNum) const override {
+        return tree.Find(courseNum);
+    }
+
+    void InOrder(const Visit& visit) const override {
+        tree.InOrder(visit);
+    }
+
+    void Range(const std::string& lo, const std::string& hi, const Visit& visit) const override {
+        tree.Range(lo, hi, visit);
+    }
+
+    void ByName(const Visit& visit) const override {
+        if constexpr (HasNameOrder<Tree>::value) {
+            tree.ByName(visit);
+        }
+        else {
+            CatalogTree::ByName(visit);
+        }
+    }
+
+    void InDepartment(const std::string& department, const Visit& visit) const override {
+        if constexpr (HasNameOrder<Tree>::value) {
+            tree.InDepartment(department, visit);
+        }
+        else {
+            CatalogTree::InDepartment(department, visit);
+        }
+    }
+};
+
+// The tree with a name, "bst", "art" or "multi", nullptr for any other name
+inline CatalogTree* makeCatalogTree(const std::string& name) {
+    if (name == "bst") {
+        return new CatalogTreeOf<BinarySearchTree>("bst");
+    }
+    if (name == "art") {
+        return new CatalogTreeOf<RadixCourseTree>("art");
+    }
+    if (name == "multi") {
+        return new CatalogTreeOf<MultiIndexCatalog>("multi");
+    }
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : Course.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef COURSE_HPP
+#define COURSE_HPP
+
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BinarySearchTree.hpp"
+#include "IndexedTree.hpp"
+#include "RadixTree.hpp"
+
+// define a structure to hold course information
+struct Course {
+    std::string courseNum; // unique identifier
+    std::string courseName;
+    std::vector<std::string> prereqs;
+    std::vector<std::string> attributes; // credits, cap, fee as written in the CSV
+    Course() {
+    }
+};
+
+// key of a course in the catalog tree
+struct CourseNumOf {
+    const std::string& operator()(const Course& course) const {
+        return course.courseNum;
+    }
+};
+
+// the catalog tree keeps its original name and interface
+typedef SearchTree<std::string, Course, CourseNumOf> BinarySearchTree;
+
+// same tree, reshaped towards the courses that are looked up most
+typedef SearchTree<std::string, Course, CourseNumOf, std::less<std::string>, SplayTree> SplayCourseTree;
+
+// same tree in two flat arrays, keys and 32 bit links apart from the courses
+typedef IndexedTree<std::string, Course, CourseNumOf> IndexedCourseTree;
+
+// adaptive radix tree branching on the bytes of the course number
+typedef RadixTree<Course, CourseNumOf> RadixCourseTree;
+
+// Leading letters of a course number, "CSCI" for "CSCI200"
+inline std::string departmentOf(const std::string& courseNum) {
+    size_t end = 0;
+    while (end < courseNum.size() && std::isalpha((unsigned char)courseNum[end])) {
+        end++;
+    }
+    return courseNum.substr(0, end);
+}
+
+// One line of the full course listing
+inline void displayRow(const Course& course) {
+    //output course number, course name
+    std::cout << course.courseNum << ":  "
+        << course.courseName << "   "
+        << "Prerequisites: ";
+    if (course.prereqs.size() == 0) {
+        std::cout << "None" << std::endl;
+    }
+    else {
+        for (size_t i = 0; i < course.prereqs.size(); i++) {
+            std::cout << course.prereqs[i] << " ";
+        }
+        std::cout << std::endl;
+    }
+}
+
+#endif
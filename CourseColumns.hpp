@@ -0,0 +1,286 @@
+//============================================================================
+// Name        : CourseColumns.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef COURSE_COLUMNS_HPP
+#define COURSE_COLUMNS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COURSE_COLUMNS_SSE2 1
+#endif
+
+// Numeric fields of a course, in the order they follow the prerequisites
+enum CourseColumn { CREDITS, CAP, FEE, COLUMN_COUNT };
+
+// Whether a CSV field is a number: digits with an optional leading '$' and
+// an optional fraction.
+inline bool isNumberField(const std::string& field) {
+    size_t i = !field.empty() && field[0] == '$' ? 1 : 0;
+    size_t digits = 0;
+    bool point = false;
+    for (; i < field.size(); i++) {
+        if (field[i] >= '0' && field[i] <= '9') {
+            digits++;
+        }
+        else if (field[i] == '.' && !point) {
+            point = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return digits > 0;
+}
+
+// Where the numeric fields at the end of a CSV row start, at most
+// COLUMN_COUNT of them and none before from. Fields from there on are
+// credits, cap and fee; a number before them, such as an all digit course
+// number, is a prerequisite.
+inline size_t attributeStart(const std::vector<std::string>& row, size_t from) {
+    size_t start = row.size();
+    while (start > from && row.size() - start < COLUMN_COUNT && isNumberField(row[start - 1])) {
+        start--;
+    }
+    return start;
+}
+
+// Value of up to 8 digits, all 8 converted at once inside one 64 bit word
+//
+// The digits are right aligned behind '0' padding, checked and reduced
+// in three multiply steps: pairs, then groups of four, then all eight.
+inline bool parseDigits8(const char* text, size_t len, uint32_t* value) {
+    uint64_t word = 0x3030303030303030ULL;
+    for (size_t i = 0; i < len; i++) {
+        size_t shift = (8 - len + i) * 8;
+        word = (word & ~(0xffULL << shift)) | ((uint64_t)(unsigned char)text[i] << shift);
+    }
+    // every byte must be 0x30 to 0x39
+    uint64_t high = word & 0xf0f0f0f0f0f0f0f0ULL;
+    uint64_t above = (word + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL;
+    if ((high | above) != 0x3030303030303030ULL) {
+        return false;
+    }
+    word -= 0x3030303030303030ULL;
+    word = (word * 10 + (word >> 8)) & 0x00ff00ff00ff00ffULL;
+    word = (word * 100 + (word >> 16)) & 0x0000ffff0000ffffULL;
+    word = (word * 10000 + (word >> 32)) & 0x00000000ffffffffULL;
+    *value = (uint32_t)word;
+    return true;
+}
+
+// Value of a number field, false when it is not one
+//
+// Whole and fractional parts of up to 8 digits each take the word at a
+// time path, longer ones fall back to strtod.
+inline bool parseNumberField(const std::string& field, double* value) {
+    if (!isNumberField(field)) {
+        return false;
+    }
+    const char* text = field.c_str();
+    if (*text == '$') {
+        text++;
+    }
+    const char* point = text;
+    while (*point != '\0' && *point != '.') {
+        point++;
+    }
+    size_t wholeLen = point - text;
+    size_t fractionLen = *point == '.' ? field.c_str() + field.size() - point - 1 : 0;
+    uint32_t whole = 0;
+    uint32_t fraction = 0;
+    if (wholeLen <= 8 && fractionLen <= 8 && parseDigits8(text, wholeLen, &whole)
+        && parseDigits8(point + (fractionLen > 0 ? 1 : 0), fractionLen, &fraction)) {
+        static const double scale[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+        *value = whole + fraction / scale[fractionLen];
+        return true;
+    }
+    *value = std::strtod(text, nullptr);
+    return true;
+}
+
+// Sum, extremes and count of the values present in a column
+struct ColumnSummary {
+    size_t count;
+    double sum;
+    double min;
+    double max;
+};
+
+// Numeric course fields stored column by column
+//
+// Every course gets a small integer id on first insert; each column is one
+// contiguous array of doubles indexed by that id, with NaN for a field the
+// row did not have and for ids freed by Remove (they are reused). The
+// aggregates stream a whole column two values per SSE2 instruction.
+class CourseColumns {
+
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> keys;
+    std::vector<uint32_t> freeIds;
+    std::vector<double> columns[COLUMN_COUNT];
+
+    static double missing() {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+public:
+    static const uint32_t NONE = 0xffffffffu;
+
+    // Store the numeric fields of a course, as written in the CSV
+    void Set(const std::string& courseNum, const std::vector<std::string>& fields) {
+        uint32_t id;
+        auto found = ids.find(courseNum);
+        if (found != ids.end()) {
+            id = found->second;
+        }
+        else if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            keys[id] = courseNum;
+            ids[courseNum] = id;
+        }
+        else {
+            id = (uint32_t)keys.size();
+            keys.push_back(courseNum);
+            for (int c = 0; c < COLUMN_COUNT; c++) {
+                columns[c].push_back(missing());
+            }
+            ids[courseNum] = id;
+        }
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            double value;
+            columns[c][id] = c < (int)fields.size() && parseNumberField(fields[c], &value) ? value : missing();
+        }
+    }
+
+    void Remove(const std::string& courseNum) {
+        auto found = ids.find(courseNum);
+        if (found == ids.end()) {
+            return;
+        }
+        uint32_t id = found->second;
+        for (int c = 0; c < COLUMN_COUNT; c++) {
+            columns[c][id] = missing();
+        }
+        keys[id].clear();
+        freeIds.push_back(id);
+        ids.erase(found);
+    }
+
+    // Id of a course, NONE when it has none
+    uint32_t IdOf(const std::string& courseNum) const {
+        auto found = ids.find(courseNum);
+        return found == ids.end() ? NONE : found->second;
+    }
+
+    const std::string& KeyOf(uint32_t id) const {
+        return keys[id];
+    }
+
+    // Value of one field, NaN when the course does not have it
+    double Value(CourseColumn column, uint32_t id) const {
+        return columns[column][id];
+    }
+
+    // Count, sum, min and max over every course that has the field
+    ColumnSummary Summarize(CourseColumn column) const {
+        const double* values = columns[column].data();
+        size_t n = columns[column].size();
+        size_t i = 0;
+        ColumnSummary summary;
+        summary.count = 0;
+        summary.sum = 0;
+        summary.min = std::numeric_limits<double>::infinity();
+        summary.max = -std::numeric_limits<double>::infinity();
+#ifdef COURSE_COLUMNS_SSE2
+        // min/max return their second operand when the first is NaN, and
+        // NaN lanes are masked to zero before they reach the sum
+        __m128d sum = _mm_setzero_pd();
+        __m128d low = _mm_set1_pd(summary.min);
+        __m128d high = _mm_set1_pd(summary.max);
+        __m128i count = _mm_setzero_si128();
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(values + i);
+            __m128d present = _mm_cmpord_pd(x, x);
+            sum = _mm_add_pd(sum, _mm_and_pd(x, present));
+            low = _mm_min_pd(x, low);
+            high = _mm_max_pd(x, high);
+            count = _mm_sub_epi64(count, _mm_castpd_si128(present));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, sum);
+        summary.sum = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, low);
+        summary.min = std::fmin(lanes[0], lanes[1]);
+        _mm_storeu_pd(lanes, high);
+        summary.max = std::fmax(lanes[0], lanes[1]);
+        uint64_t counts[2];
+        _mm_storeu_si128((__m128i*)counts, count);
+        summary.count = (size_t)(counts[0] + counts[1]);
+#endif
+        for (; i < n; i++) {
+            if (!std::isnan(values[i])) {
+                summary.count++;
+                summary.sum += values[i];
+                summary.min = std::fmin(summary.min, values[i]);
+                summary.max = std::fmax(summary.max, values[i]);
+            }
+        }
+        return summary;
+    }
+
+    // Ids of the courses with lo <= field <= hi
+    std::vector<uint32_t> Filter(CourseColumn column, double lo, double hi) const {
+        const double* values = columns[column].data();
+        size_t n = columns[column].size();
+        size_t i = 0;
+        std::vector<uint32_t> matches;
+#ifdef COURSE_COLUMNS_SSE2
+        // comparisons with NaN are false, so missing fields never match
+        __m128d low = _mm_set1_pd(lo);
+        __m128d high = _mm_set1_pd(hi);
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(values + i);
+            int mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(x, low), _mm_cmple_pd(x, high)));
+            if (mask & 1) {
+                matches.push_back((uint32_t)i);
+            }
+            if (mask & 2) {
+                matches.push_back((uint32_t)i + 1);
+            }
+        }
+#endif
+        for (; i < n; i++) {
+            if (values[i] >= lo && values[i] <= hi) {
+                matches.push_back((uint32_t)i);
+            }
+        }
+        return matches;
+    }
+
+    // Sum of one field over some courses, such as the credits of a degree plan.
+    // Courses without the field add nothing.
+    double Sum(CourseColumn column, const std::vector<uint32_t>& courseIds) const {
+        double total = 0;
+        for (size_t i = 0; i < courseIds.size(); i++) {
+            double value = columns[column][courseIds[i]];
+            if (!std::isnan(value)) {
+                total += value;
+            }
+        }
+        return total;
+    }
+};
+
+#endif
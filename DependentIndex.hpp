@@ -0,0 +1,304 @@
+//============================================================================
+// Name        : DependentIndex.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef DEPENDENT_INDEX_HPP
+#define DEPENDENT_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Course.hpp"
+
+// Which courses need a course, directly or through other courses
+//
+// Every course number seen, whether as a course or only as somebody's
+// prerequisite, gets a small id; each id keeps its prerequisites and the
+// reverse list of courses naming it, so a prerequisite named before its
+// course is added links up as soon as the course arrives.
+//
+// The transitive dependents of a course are worked out on the first query
+// and kept. Later edits keep the kept answers exact: a new edge from d to
+// p adds d and everything depending on d to p and to every transitive
+// prerequisite of p; a removed edge drops the answers of those same
+// courses, as another path may still connect them, and they are worked
+// out again when next asked for. Nothing is kept until the first query, so
+// loading pays only for the adjacency lists.
+class DependentIndex {
+
+private:
+    static const uint32_t NONE = 0xffffffffu;
+    // drop every kept answer once they hold this many ids together
+    static const size_t MAX_KEPT = 1 << 22;
+
+    struct Node {
+        std::string key;
+        bool present;                       // a course, not just a name in a prerequisite list
+        std::vector<uint32_t> prereqs;
+        std::vector<uint32_t> dependents;
+        bool kept;                          // closure holds the transitive dependents
+        std::vector<uint32_t> closure;      // sorted ids, never the course itself
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<uint32_t> freeIds;
+    size_t keptIds;
+    size_t keptCount;
+
+    // queries fill kept answers under a read lock of the catalog
+    mutable std::mutex lock;
+    // visited marks, a mark equal to epoch means seen in this walk
+    std::vector<uint32_t> mark;
+    uint32_t epoch;
+
+    uint32_t idOf(const std::string& key) const {
+        auto found = ids.find(key);
+        return found == ids.end() ? NONE : found->second;
+    }
+
+    uint32_t intern(const std::string& key) {
+        uint32_t id = idOf(key);
+        if (id != NONE) {
+            return id;
+        }
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else {
+            id = (uint32_t)nodes.size();
+            nodes.push_back(Node());
+            mark.push_back(0);
+        }
+        Node& node = nodes[id];
+        node.key = key;
+        node.present = false;
+        node.kept = false;
+        ids[key] = id;
+        return id;
+    }
+
+    // give the id back once nothing refers to it
+    void release(uint32_t id) {
+        Node& node = nodes[id];
+        if (node.present || !node.dependents.empty() || !node.prereqs.empty()) {
+            return;
+        }
+        forget(id);
+        ids.erase(node.key);
+        node.key.clear();
+        freeIds.push_back(id);
+    }
+
+    void forget(uint32_t id) {
+        Node& node = nodes[id];
+        if (node.kept) {
+            keptIds -= node.closure.size();
+            keptCount--;
+            node.kept = false;
+            std::vector<uint32_t>().swap(node.closure);
+        }
+    }
+
+    void nextEpoch() {
+        if (++epoch == 0) {
+            std::fill(mark.begin(), mark.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    // from, then every id reachable from it through edges, each once
+    template <typename Edges>
+    void reach(uint32_t from, Edges edges, std::vector<uint32_t>& out) {
+        nextEpoch();
+        out.clear();
+        out.push_back(from);
+        mark[from] = epoch;
+        for (size_t i = 0; i < out.size(); i++) {
+            const std::vector<uint32_t>& next = edges(nodes[out[i]]);
+            for (size_t e = 0; e < next.size(); e++) {
+                if (mark[next[e]] != epoch) {
+                    mark[next[e]] = epoch;
+                    out.push_back(next[e]);
+                }
+            }
+        }
+    }
+
+    static const std::vector<uint32_t>& prereqsOf(const Node& node) {
+        return node.prereqs;
+    }
+
+    static const std::vector<uint32_t>& dependentsOf(const Node& node) {
+        return node.dependents;
+    }
+
+    // the transitive dependents of id, worked out now unless kept
+    const std::vector<uint32_t>& closureOf(uint32_t id) {
+        Node& node = nodes[id];
+        if (!node.kept) {
+            std::vector<uint32_t> found;
+            reach(id, dependentsOf, found);
+            // the course itself is first unless it needs itself
+            found.erase(found.begin());
+            found.erase(std::remove(found.begin(), found.end(), id), found.end());
+            std::sort(found.begin(), found.end());
+            if (keptIds + found.size() > MAX_KEPT) {
+                for (size_t i = 0; i < nodes.size(); i++) {
+                    forget((uint32_t)i);
+                }
+            }
+            node.closure.swap(found);
+            node.kept = true;
+            keptIds += node.closure.size();
+            keptCount++;
+        }
+        return node.closure;
+    }
+
+    // d now needs p: everything kept for p or a prerequisite of it gains d
+    // and the dependents of d
+    void linked(uint32_t d, uint32_t p) {
+        if (keptCount == 0) {
+            return;
+        }
+        std::vector<uint32_t> affected;
+        reach(p, prereqsOf, affected);
+        std::vector<uint32_t> gained;
+        reach(d, dependentsOf, gained);
+        bool cycle = false;
+        for (size_t i = 0; i < affected.size() && !cycle; i++) {
+            cycle = mark[affected[i]] == epoch;
+        }
+        std::sort(gained.begin(), gained.end());
+        std::vector<uint32_t> merged;
+        for (size_t i = 0; i < affected.size(); i++) {
+            Node& node = nodes[affected[i]];
+            if (!node.kept) {
+                continue;
+            }
+            if (cycle) {
+                // the edge closes a loop through these courses, simpler to start over
+                forget(affected[i]);
+                continue;
+            }
+            merged.clear();
+            std::set_union(node.closure.begin(), node.closure.end(), gained.begin(), gained.end(),
+                std::back_inserter(merged));
+            keptIds += merged.size() - node.closure.size();
+            node.closure.swap(merged);
+        }
+    }
+
+    // d no longer needs p: what was kept for p or a prerequisite of it may shrink
+    void unlinked(uint32_t p) {
+        if (keptCount == 0) {
+            return;
+        }
+        std::vector<uint32_t> affected;
+        reach(p, prereqsOf, affected);
+        for (size_t i = 0; i < affected.size(); i++) {
+            forget(affected[i]);
+        }
+    }
+
+    // unlink course d from its prerequisites, the id stays taken
+    void unlink(uint32_t d) {
+        Node& node = nodes[d];
+        node.present = false;
+        std::vector<uint32_t> prereqs;
+        prereqs.swap(node.prereqs);
+        for (size_t i = 0; i < prereqs.size(); i++) {
+            uint32_t p = prereqs[i];
+            std::vector<uint32_t>& dependents = nodes[p].dependents;
+            dependents.erase(std::find(dependents.begin(), dependents.end(), d));
+            unlinked(p);
+            if (p != d) {
+                release(p);
+            }
+        }
+    }
+
+public:
+    DependentIndex() {
+        keptIds = 0;
+        keptCount = 0;
+        epoch = 0;
+    }
+
+    // Link a course to its prerequisites, replacing it if already added
+    void Add(const Course& course) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t d = intern(course.courseNum);
+        if (nodes[d].present) {
+            unlink(d);
+        }
+        nodes[d].present = true;
+        for (size_t i = 0; i < course.prereqs.size(); i++) {
+            uint32_t p = intern(course.prereqs[i]);
+            std::vector<uint32_t>& prereqs = nodes[d].prereqs;
+            if (std::find(prereqs.begin(), prereqs.end(), p) != prereqs.end()) {
+                continue;
+            }
+            prereqs.push_back(p);
+            nodes[p].dependents.push_back(d);
+            linked(d, p);
+        }
+    }
+
+    // Unlink a course from its prerequisites; courses naming it keep pointing at it
+    void Remove(const std::string& courseNum) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t d = idOf(courseNum);
+        if (d != NONE && nodes[d].present) {
+            unlink(d);
+            release(d);
+        }
+    }
+
+    // Courses naming a course as a prerequisite, empty when there are none
+    std::vector<std::string> Direct(const std::string& courseNum) const {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::string> names;
+        uint32_t id = idOf(courseNum);
+        if (id != NONE) {
+            const std::vector<uint32_t>& dependents = nodes[id].dependents;
+            for (size_t i = 0; i < dependents.size(); i++) {
+                names.push_back(nodes[dependents[i]].key);
+            }
+        }
+        return names;
+    }
+
+    // Courses needing a course directly or through other courses
+    std::vector<std::string> Transitive(const std::string& courseNum) {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::string> names;
+        uint32_t id = idOf(courseNum);
+        if (id != NONE) {
+            const std::vector<uint32_t>& closure = closureOf(id);
+            names.reserve(closure.size());
+            for (size_t i = 0; i < closure.size(); i++) {
+                names.push_back(nodes[closure[i]].key);
+            }
+        }
+        return names;
+    }
+
+    // Number of courses needing a course directly or not, cheaper than
+    // Transitive once the answer is kept
+    size_t TransitiveCount(const std::string& courseNum) {
+        std::lock_guard<std::mutex> guard(lock);
+        uint32_t id = idOf(courseNum);
+        return id == NONE ? 0 : closureOf(id).size();
+    }
+};
+
+#endif
@@ -0,0 +1,202 @@
+//============================================================================
+// Name        : EmbeddedCatalog.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef EMBEDDED_CATALOG_HPP
+#define EMBEDDED_CATALOG_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Course.hpp"
+
+// A course compiled into the program, pointing into static strings
+struct EmbeddedCourse {
+    std::string_view courseNum;
+    std::string_view courseName;
+    const std::string_view* prereqs;
+    size_t prereqCount;
+    const std::string_view* attributes;   // credits, cap, fee as written in the CSV
+    size_t attributeCount;
+
+    // The same course as a Course, for code shared with the loaded catalog
+    Course ToCourse() const {
+        Course course;
+        course.courseNum = std::string(courseNum);
+        course.courseName = std::string(courseName);
+        for (size_t i = 0; i < prereqCount; i++) {
+            course.prereqs.push_back(std::string(prereqs[i]));
+        }
+        for (size_t i = 0; i < attributeCount; i++) {
+            course.attributes.push_back(std::string(attributes[i]));
+        }
+        return course;
+    }
+};
+
+// Fixed catalog with a minimal perfect hash computed by the compiler
+//
+// Written out by CatalogEmbed as a constexpr object, so a lookup needs no
+// load step, no heap and no tree: hash the course number, read the pilot
+// of its bucket, hash again with the pilot and compare the one course in
+// that slot. The pilots are found PTHash style, buckets with the most keys
+// first, each trying pilots until all its keys land in free slots. With
+// N slots for N courses every slot is used.
+//
+// Courses must be in increasing key order without duplicates, as the
+// generator writes them; InOrder walks them in that order. Compilers cap
+// how much work a constant expression may do, which is plenty for a few
+// thousand courses; bigger catalogs need -fconstexpr-ops-limit (GCC) or
+// -fconstexpr-steps (Clang) raised.
+template <size_t N>
+class EmbeddedCatalog {
+
+private:
+    // about two keys per bucket; with every slot used, fuller buckets make
+    // the last ones try pilots far longer
+    static const size_t BUCKETS = N / 2 + 1;
+    // give up on a bucket after this many pilots, Built() then says false
+    static const uint32_t MAX_PILOT = 0xffff;
+
+    const EmbeddedCourse* courses;
+    std::array<uint16_t, BUCKETS> pilots = {};
+    std::array<uint32_t, N> slots = {};
+    bool built = false;
+
+    static constexpr uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // FNV-1a, then the same 64 bit mixer the Bloom filter finishes with
+    static constexpr uint64_t hash(std::string_view key) {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < key.size(); i++) {
+            h ^= (unsigned char)key[i];
+            h *= 1099511628211ULL;
+        }
+        return mix(h);
+    }
+
+    static constexpr size_t bucketOf(uint64_t h) {
+        return (size_t)(((h >> 32) * (uint64_t)BUCKETS) >> 32);
+    }
+
+    static constexpr size_t slotOf(uint64_t h, uint32_t pilot) {
+        return (size_t)(((mix(h ^ (pilot * 0x9e3779b97f4a7c15ULL)) >> 32) * (uint64_t)N) >> 32);
+    }
+
+public:
+    constexpr explicit EmbeddedCatalog(const EmbeddedCourse (&list)[N]) : courses(list) {
+        std::array<uint64_t, N> hashes = {};
+        std::array<size_t, BUCKETS + 1> starts = {};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = hash(list[i].courseNum);
+            starts[bucketOf(hashes[i]) + 1]++;
+        }
+        size_t largest = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            largest = starts[b + 1] > largest ? starts[b + 1] : largest;
+            starts[b + 1] += starts[b];
+        }
+        // keys grouped by bucket
+        std::array<size_t, N> members = {};
+        std::array<size_t, BUCKETS> filled = {};
+        for (size_t i = 0; i < N; i++) {
+            size_t b = bucketOf(hashes[i]);
+            members[starts[b] + filled[b]++] = i;
+        }
+
+        std::array<bool, N> taken = {};
+        std::array<size_t, 64> tried = {};
+        for (size_t size = largest; size > 0; size--) {
+            for (size_t b = 0; b < BUCKETS; b++) {
+                if (starts[b + 1] - starts[b] != size) {
+                    continue;
+                }
+                uint32_t pilot = 0;
+                for (;; pilot++) {
+                    if (pilot > MAX_PILOT || size > tried.size()) {
+                        return;
+                    }
+                    // every key of the bucket in a free slot, no two in the same
+                    bool fits = true;
+                    for (size_t k = 0; k < size && fits; k++) {
+                        tried[k] = slotOf(hashes[members[starts[b] + k]], pilot);
+                        fits = !taken[tried[k]];
+                        for (size_t j = 0; j < k && fits; j++) {
+                            fits = tried[j] != tried[k];
+                        }
+                    }
+                    if (fits) {
+                        break;
+                    }
+                }
+                pilots[b] = (uint16_t)pilot;
+                for (size_t k = 0; k < size; k++) {
+                    taken[tried[k]] = true;
+                    slots[tried[k]] = (uint32_t)members[starts[b] + k];
+                }
+            }
+        }
+        built = true;
+    }
+
+    // Whether every course got a slot, checked by the generated header
+    constexpr bool Built() const {
+        return built;
+    }
+
+    constexpr size_t Size() const {
+        return N;
+    }
+
+    // Bytes of the pilots and slots, what the hash adds to the courses
+    constexpr size_t HashBytes() const {
+        return sizeof(pilots) + sizeof(slots);
+    }
+
+    // Find the course with a key, nullptr when there is none
+    constexpr const EmbeddedCourse* Find(std::string_view courseNum) const {
+        if (N == 0) {
+            return nullptr;
+        }
+        uint64_t h = hash(courseNum);
+        const EmbeddedCourse* course = &courses[slots[slotOf(h, pilots[bucketOf(h)])]];
+        return course->courseNum == courseNum ? course : nullptr;
+    }
+
+    // Search for a course, a default constructed one when there is none
+    Course Search(const std::string& courseNum) const {
+        const EmbeddedCourse* found = Find(courseNum);
+        if (found != nullptr) {
+            return found->ToCourse();
+        }
+        return Course();
+    }
+
+    // Visit every course in key order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        for (size_t i = 0; i < N; i++) {
+            visit(courses[i]);
+        }
+    }
+
+    // Print every course in key order with displayRow
+    void InOrder() const {
+        InOrder([](const EmbeddedCourse& course) {
+            displayRow(course.ToCourse());
+        });
+    }
+};
+
+#endif
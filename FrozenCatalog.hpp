@@ -0,0 +1,405 @@
+//============================================================================
+// Name        : FrozenCatalog.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef FROZEN_CATALOG_HPP
+#define FROZEN_CATALOG_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Course.hpp"
+#include "LearnedIndex.hpp"
+
+// Read-only catalog with front coded course numbers
+//
+// Courses are kept in key order in blocks of 16. The first key of every
+// block is stored whole in a small index that is binary searched; the
+// other keys store only how many leading bytes they share with the key
+// before them and the bytes that differ. Names and prerequisites live in
+// separate arrays so a lookup only touches the keys until it has a match.
+//
+// Once every course is in, UseHeadSearch turns the heads into order
+// preserving integers and picks how they are searched: binary search, in
+// Eytzinger order or through a LearnedIndex that predicts the block. Heads
+// whose integers come out equal are told apart by comparing the whole key.
+class FrozenCatalog {
+
+public:
+    // How a lookup finds the block of a key
+    enum HeadSearch {
+        HEAD_BINARY,
+        HEAD_EYTZINGER,
+        HEAD_LEARNED
+    };
+
+private:
+    static const size_t BLOCK = 16;
+
+    // first key of every block, back to back, with their start offsets
+    std::string heads;
+    std::vector<uint32_t> headOffsets;
+    // per block: for every key after the first, varint shared length,
+    // varint suffix length, suffix bytes
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> blockOffsets;
+    std::string lastKey;
+
+    // every head as an integer, empty until UseHeadSearch
+    KeyEncoder encoder;
+    std::vector<uint64_t> headKeys;
+    HeadSearch headSearch;
+    // headKeys laid out as an implicit tree, children of k at 2k and 2k + 1,
+    // with the sorted position of each; slot 0 unused
+    std::vector<uint64_t> eytzinger;
+    std::vector<uint32_t> eytzingerRank;
+    LearnedIndex learned;
+
+    std::vector<std::string> names;
+    std::vector<std::vector<std::string>> prereqs;
+
+    static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    static uint32_t getVarint(const uint8_t*& p) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            value |= (uint32_t)(*p++ & 0x7f) << shift;
+            shift += 7;
+        }
+        value |= (uint32_t)(*p++) << shift;
+        return value;
+    }
+
+    size_t blocks() const {
+        return headOffsets.size();
+    }
+
+    // compare key against the head of a block
+    int compareHead(size_t block, const std::string& key) const {
+        size_t start = headOffsets[block];
+        size_t end = block + 1 < blocks() ? headOffsets[block + 1] : heads.size();
+        return key.compare(0, std::string::npos, heads, start, end - start);
+    }
+
+    // fill the Eytzinger array in order, an in-order walk of the implicit tree
+    void layout(size_t k, size_t& next) {
+        if (k >= eytzinger.size()) {
+            return;
+        }
+        layout(2 * k, next);
+        eytzinger[k] = headKeys[next];
+        eytzingerRank[k] = (uint32_t)next;
+        next++;
+        layout(2 * k + 1, next);
+    }
+
+    // first head whose code is not below code, blocks() if there is none
+    size_t lowerBoundHead(uint64_t code) const {
+        switch (headSearch) {
+        case HEAD_EYTZINGER: {
+            // branch free descent, the path bits say where the bound is
+            size_t k = 1;
+            size_t n = eytzinger.size();
+            while (k < n) {
+#ifdef __GNUC__
+                __builtin_prefetch(eytzinger.data() + (8 * k < n ? 8 * k : 0));
+#endif
+                k = 2 * k + (eytzinger[k] < code ? 1 : 0);
+            }
+            // undo the right turns taken after the last left one, then that left one
+            while (k & 1) {
+                k >>= 1;
+            }
+            k >>= 1;
+            return k == 0 ? blocks() : eytzingerRank[k];
+        }
+        case HEAD_LEARNED:
+            return learned.LowerBound(headKeys.data(), headKeys.size(), code);
+        default:
+            return std::lower_bound(headKeys.begin(), headKeys.end(), code) - headKeys.begin();
+        }
+    }
+
+    // last block whose head is not greater than key, or blocks() if key is before all
+    size_t findBlock(const std::string& key) const {
+        size_t block;
+        if (headKeys.size() == blocks()) {
+            uint64_t code = encoder.Encode(key);
+            block = lowerBoundHead(code);
+            // heads with the same code need the whole key
+            while (block < blocks() && headKeys[block] == code && compareHead(block, key) >= 0) {
+                block++;
+            }
+        }
+        else {
+            // no integers yet, binary search the heads themselves
+            size_t lo = 0;
+            size_t hi = blocks();
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (compareHead(mid, key) < 0) {
+                    hi = mid;
+                }
+                else {
+                    lo = mid + 1;
+                }
+            }
+            block = lo;
+        }
+        return block == 0 ? blocks() : block - 1;
+    }
+
+    // walks the keys of the catalog in order starting at a block
+    struct Cursor {
+        const FrozenCatalog* catalog;
+        size_t position;
+        const uint8_t* p;
+        std::string key;
+
+        Cursor(const FrozenCatalog* aCatalog, size_t block) {
+            catalog = aCatalog;
+            position = block * BLOCK;
+            p = nullptr;
+            loadHead(block);
+        }
+
+        void loadHead(size_t block) {
+            size_t start = catalog->headOffsets[block];
+            size_t end = block + 1 < catalog->blocks() ? catalog->headOffsets[block + 1] : catalog->heads.size();
+            key.assign(catalog->heads, start, end - start);
+            p = catalog->bytes.data() + catalog->blockOffsets[block];
+        }
+
+        bool valid() const {
+            return position < catalog->names.size();
+        }
+
+        void next() {
+            position++;
+            if (!valid()) {
+                return;
+            }
+            if (position % BLOCK == 0) {
+                loadHead(position / BLOCK);
+                return;
+            }
+            uint32_t shared = getVarint(p);
+            uint32_t suffix = getVarint(p);
+            key.resize(shared);
+            key.append((const char*)p, suffix);
+            p += suffix;
+        }
+    };
+
+    Course courseAt(const std::string& key, size_t position) const {
+        Course course;
+        course.courseNum = key;
+        course.courseName = names[position];
+        course.prereqs = prereqs[position];
+        return course;
+    }
+
+    // position of a key, false when it is not in the catalog
+    bool locate(const std::string& key, size_t& position) const {
+        size_t block = findBlock(key);
+        if (block == blocks()) {
+            return false;
+        }
+        // walk the block keeping how many leading bytes the current key
+        // shares with the one looked for, the shared length stored with
+        // each key then settles most steps without reading its suffix
+        size_t start = headOffsets[block];
+        size_t end = block + 1 < blocks() ? headOffsets[block + 1] : heads.size();
+        const char* head = heads.data() + start;
+        size_t matched = 0;
+        size_t limit = key.size() < end - start ? key.size() : end - start;
+        while (matched < limit && key[matched] == head[matched]) {
+            matched++;
+        }
+        size_t current = block * BLOCK;
+        if (matched == key.size() && matched == end - start) {
+            position = current;
+            return true;
+        }
+        const uint8_t* p = bytes.data() + blockOffsets[block];
+        for (size_t i = 1; i < BLOCK && current + 1 < names.size(); i++) {
+            current++;
+            size_t shared = getVarint(p);
+            size_t suffix = getVarint(p);
+            const uint8_t* bytesAt = p;
+            p += suffix;
+            if (shared > matched) {
+                // same as the last key where that one was already below
+                continue;
+            }
+            if (shared < matched) {
+                // greater than the last key where that one still matched
+                return false;
+            }
+            size_t j = 0;
+            while (j < suffix && matched < key.size() && bytesAt[j] == (uint8_t)key[matched]) {
+                j++;
+                matched++;
+            }
+            if (j == suffix) {
+                if (matched == key.size()) {
+                    position = current;
+                    return true;
+                }
+                // a prefix of the key, still below it
+                continue;
+            }
+            if (matched == key.size() || bytesAt[j] > (uint8_t)key[matched]) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+public:
+    FrozenCatalog() {
+        headSearch = HEAD_BINARY;
+    }
+
+    // Append a course, courses must arrive in increasing key order; lookups
+    // compare whole heads until UseHeadSearch is called again
+    void Add(const Course& course) {
+        size_t position = names.size();
+        const std::string& key = course.courseNum;
+        if (position % BLOCK == 0) {
+            headOffsets.push_back((uint32_t)heads.size());
+            heads += key;
+            blockOffsets.push_back((uint32_t)bytes.size());
+        }
+        else {
+            size_t shared = 0;
+            size_t limit = key.size() < lastKey.size() ? key.size() : lastKey.size();
+            while (shared < limit && key[shared] == lastKey[shared]) {
+                shared++;
+            }
+            putVarint(bytes, (uint32_t)shared);
+            putVarint(bytes, (uint32_t)(key.size() - shared));
+            bytes.insert(bytes.end(), key.begin() + shared, key.end());
+        }
+        lastKey = key;
+        names.push_back(course.courseName);
+        prereqs.push_back(course.prereqs);
+    }
+
+    // Copy a tree into a frozen catalog
+    template <typename Tree>
+    void Freeze(const Tree& tree) {
+        tree.InOrder([this](const Course& course) {
+            Add(course);
+        });
+        heads.shrink_to_fit();
+        bytes.shrink_to_fit();
+        // the learned search finds the block sooner on large catalogs, but
+        // the scan of the block takes most of a lookup and whole lookups
+        // come out even with binary search, so that stays the default
+        UseHeadSearch(HEAD_BINARY);
+    }
+
+    // Encode the heads added so far and build what a head search needs,
+    // one pass over the heads for each
+    void UseHeadSearch(HeadSearch mode) {
+        std::vector<std::string> headList(blocks());
+        for (size_t block = 0; block < blocks(); block++) {
+            size_t start = headOffsets[block];
+            size_t end = block + 1 < blocks() ? headOffsets[block + 1] : heads.size();
+            headList[block].assign(heads, start, end - start);
+        }
+        encoder.Build(headList.data(), headList.size());
+        headKeys.resize(blocks());
+        for (size_t block = 0; block < blocks(); block++) {
+            headKeys[block] = encoder.Encode(headList[block]);
+        }
+
+        eytzinger.clear();
+        eytzingerRank.clear();
+        learned.Build(nullptr, 0);
+        if (mode == HEAD_EYTZINGER) {
+            eytzinger.resize(headKeys.size() + 1);
+            eytzingerRank.resize(headKeys.size() + 1);
+            size_t next = 0;
+            layout(1, next);
+        }
+        else if (mode == HEAD_LEARNED) {
+            learned.Build(headKeys.data(), headKeys.size());
+        }
+        headSearch = mode;
+    }
+
+    size_t Size() const {
+        return names.size();
+    }
+
+    // Bytes used by the keys and the block index
+    size_t KeyBytes() const {
+        return heads.capacity() + headOffsets.capacity() * sizeof(uint32_t)
+            + bytes.capacity() + blockOffsets.capacity() * sizeof(uint32_t)
+            + headKeys.capacity() * sizeof(uint64_t) + eytzinger.capacity() * sizeof(uint64_t)
+            + eytzingerRank.capacity() * sizeof(uint32_t) + learned.Bytes();
+    }
+
+    // Block a key falls in, or the number of blocks when it sorts before
+    // every course; only the head search, so it can be timed on its own
+    size_t BlockOf(const std::string& key) const {
+        return findBlock(key);
+    }
+
+    // Whether a course is in the catalog
+    bool Contains(const std::string& key) const {
+        size_t position;
+        return locate(key, position);
+    }
+
+    // Search for a course, an empty one when there is none
+    Course Search(const std::string& key) const {
+        size_t position;
+        if (locate(key, position)) {
+            return courseAt(key, position);
+        }
+        return Course();
+    }
+
+    // Visit every course in key order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        if (names.empty()) {
+            return;
+        }
+        for (Cursor cursor(this, 0); cursor.valid(); cursor.next()) {
+            visit(courseAt(cursor.key, cursor.position));
+        }
+    }
+
+    // Visit every course with lo <= key <= hi in key order
+    template <typename Visit>
+    void Range(const std::string& lo, const std::string& hi, Visit visit) const {
+        if (names.empty()) {
+            return;
+        }
+        size_t block = findBlock(lo);
+        Cursor cursor(this, block == blocks() ? 0 : block);
+        while (cursor.valid() && cursor.key.compare(lo) < 0) {
+            cursor.next();
+        }
+        while (cursor.valid() && cursor.key.compare(hi) <= 0) {
+            visit(courseAt(cursor.key, cursor.position));
+            cursor.next();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,280 @@
+//============================================================================
+// Name        : FuzzyIndex.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef FUZZY_INDEX_HPP
+#define FUZZY_INDEX_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Edit distance between a pattern of at most 64 characters and a text
+//
+// Myers' bit-parallel algorithm (Hyyro's formulation): one column of the
+// dynamic programming table is kept as vertical +1/-1 bit vectors, so each
+// character of text costs a handful of word operations.
+inline int myersDistance(const std::string& pattern, const std::string& text) {
+    size_t m = pattern.size();
+    if (m == 0) {
+        return (int)text.size();
+    }
+    uint64_t peq[256] = { 0 };
+    for (size_t i = 0; i < m; i++) {
+        peq[(unsigned char)pattern[i]] |= 1ULL << i;
+    }
+    uint64_t pv = ~0ULL;
+    uint64_t mv = 0;
+    uint64_t high = 1ULL << (m - 1);
+    int score = (int)m;
+    for (unsigned char c : text) {
+        uint64_t eq = peq[c];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & high) {
+            score++;
+        }
+        else if (mh & high) {
+            score--;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// Edit distance for patterns too long for one machine word
+inline int editDistance(const std::string& a, const std::string& b) {
+    if (a.size() <= 64) {
+        return myersDistance(a, b);
+    }
+    std::vector<int> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) {
+        row[j] = (int)j;
+    }
+    for (size_t i = 1; i <= a.size(); i++) {
+        int diagonal = row[0];
+        row[0] = (int)i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            int above = row[j];
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1),
+                diagonal + (a[i - 1] == b[j - 1] ? 0 : 1));
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+// A course suggested for a query that did not match exactly
+struct FuzzyMatch {
+    std::string courseNum;
+    int distance;
+};
+
+// Trigram index over course numbers and names for typo tolerant lookup
+//
+// Course numbers and names are indexed as separate lower case entries.
+// A query counts shared trigrams against the entries, keeps the best
+// candidates and ranks them by true edit distance.
+class FuzzyIndex {
+
+private:
+    // how many candidates get an exact edit distance check
+    static const size_t VERIFY = 64;
+    // how many candidates the trigram count may gather before the longer
+    // lists stop adding new ones
+    static const size_t BUDGET = 1024;
+
+    std::unordered_map<uint32_t, std::vector<uint32_t>> grams;
+    std::unordered_map<std::string, std::vector<uint32_t>> entriesOf;
+    std::vector<std::string> texts;
+    std::vector<std::string> owners;
+    std::vector<bool> live;
+    size_t dead;
+
+    static std::string lower(const std::string& text) {
+        std::string out(text);
+        for (size_t i = 0; i < out.size(); i++) {
+            out[i] = (char)std::tolower((unsigned char)out[i]);
+        }
+        return out;
+    }
+
+    // distinct trigrams of a string padded so short strings still get some
+    static std::vector<uint32_t> trigrams(const std::string& text) {
+        std::string padded = "\x01\x01" + text + "\x01";
+        std::vector<uint32_t> out;
+        for (size_t i = 0; i + 3 <= padded.size(); i++) {
+            out.push_back(((uint32_t)(unsigned char)padded[i] << 16)
+                | ((uint32_t)(unsigned char)padded[i + 1] << 8)
+                | (uint32_t)(unsigned char)padded[i + 2]);
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    void addEntry(const std::string& courseNum, const std::string& text) {
+        if (text.empty()) {
+            return;
+        }
+        uint32_t id = (uint32_t)texts.size();
+        texts.push_back(lower(text));
+        owners.push_back(courseNum);
+        live.push_back(true);
+        entriesOf[courseNum].push_back(id);
+        std::vector<uint32_t> list = trigrams(texts[id]);
+        for (size_t i = 0; i < list.size(); i++) {
+            grams[list[i]].push_back(id);
+        }
+    }
+
+    // rebuild without the removed entries once they outnumber the live ones
+    void compact() {
+        std::vector<std::string> oldTexts;
+        std::vector<std::string> oldOwners;
+        std::vector<bool> oldLive;
+        oldTexts.swap(texts);
+        oldOwners.swap(owners);
+        oldLive.swap(live);
+        grams.clear();
+        entriesOf.clear();
+        dead = 0;
+        for (size_t i = 0; i < oldTexts.size(); i++) {
+            if (oldLive[i]) {
+                addEntry(oldOwners[i], oldTexts[i]);
+            }
+        }
+    }
+
+public:
+    FuzzyIndex() {
+        dead = 0;
+    }
+
+    // Index a course number and name
+    void Add(const std::string& courseNum, const std::string& courseName) {
+        if (entriesOf.find(courseNum) != entriesOf.end()) {
+            Remove(courseNum);
+        }
+        addEntry(courseNum, courseNum);
+        addEntry(courseNum, courseName);
+    }
+
+    // Drop a course, its entries stay in the lists until the next compaction
+    void Remove(const std::string& courseNum) {
+        auto found = entriesOf.find(courseNum);
+        if (found == entriesOf.end()) {
+            return;
+        }
+        for (size_t i = 0; i < found->second.size(); i++) {
+            live[found->second[i]] = false;
+            texts[found->second[i]].clear();
+            dead++;
+        }
+        entriesOf.erase(found);
+        if (dead > 1024 && dead > texts.size() - dead) {
+            compact();
+        }
+    }
+
+    // Up to k courses closest to the query by edit distance
+    std::vector<FuzzyMatch> Search(const std::string& query, size_t k) const {
+        std::vector<FuzzyMatch> result;
+        std::string text = lower(query);
+        if (text.empty() || k == 0) {
+            return result;
+        }
+
+        // rarest trigrams first, they say the most about the query
+        std::vector<const std::vector<uint32_t>*> lists;
+        std::vector<uint32_t> list = trigrams(text);
+        for (size_t i = 0; i < list.size(); i++) {
+            auto found = grams.find(list[i]);
+            if (found != grams.end()) {
+                lists.push_back(&found->second);
+            }
+        }
+        std::sort(lists.begin(), lists.end(),
+            [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+                return a->size() < b->size();
+            });
+
+        // count shared trigrams; the rarest list is always counted in full,
+        // so no entry is dropped for where it sits in a list, and once the
+        // budget is spent the longer lists only vote for entries that are
+        // already candidates, walking whichever of the two is shorter
+        std::unordered_map<uint32_t, int> shared;
+        for (size_t i = 0; i < lists.size(); i++) {
+            const std::vector<uint32_t>& ids = *lists[i];
+            if (shared.empty() || shared.size() + ids.size() <= BUDGET) {
+                for (size_t j = 0; j < ids.size(); j++) {
+                    shared[ids[j]]++;
+                }
+            }
+            else if (ids.size() < shared.size()) {
+                for (size_t j = 0; j < ids.size(); j++) {
+                    auto candidate = shared.find(ids[j]);
+                    if (candidate != shared.end()) {
+                        candidate->second++;
+                    }
+                }
+            }
+            else {
+                for (auto& candidate : shared) {
+                    if (std::binary_search(ids.begin(), ids.end(), candidate.first)) {
+                        candidate.second++;
+                    }
+                }
+            }
+        }
+
+        std::vector<std::pair<int, uint32_t>> ranked;
+        for (auto& candidate : shared) {
+            if (live[candidate.first]) {
+                ranked.push_back(std::make_pair(-candidate.second, candidate.first));
+            }
+        }
+        if (ranked.size() > VERIFY) {
+            std::nth_element(ranked.begin(), ranked.begin() + VERIFY, ranked.end());
+            ranked.resize(VERIFY);
+        }
+
+        // verify the candidates and keep the closest entry of each course
+        std::unordered_map<std::string, int> best;
+        for (size_t i = 0; i < ranked.size(); i++) {
+            uint32_t id = ranked[i].second;
+            int distance = editDistance(text, texts[id]);
+            auto found = best.find(owners[id]);
+            if (found == best.end() || distance < found->second) {
+                best[owners[id]] = distance;
+            }
+        }
+        for (auto& course : best) {
+            FuzzyMatch match;
+            match.courseNum = course.first;
+            match.distance = course.second;
+            result.push_back(match);
+        }
+        std::sort(result.begin(), result.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+            if (a.distance != b.distance) {
+                return a.distance < b.distance;
+            }
+            return a.courseNum < b.courseNum;
+        });
+        if (result.size() > k) {
+            result.resize(k);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,316 @@
+//============================================================================
+// Name        : IndexedTree.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef INDEXED_TREE_HPP
+#define INDEXED_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "BinarySearchTree.hpp"
+#include "CatalogMetrics.hpp"
+
+// Binary search tree kept in two parallel vectors instead of heap nodes
+//
+// A node is a slot number. The hot vector holds what a search reads, the
+// key and two 32 bit child slots; the cold vector holds the values, which
+// a search only touches once it has found its slot. The links are slot
+// numbers, so a copy of the vectors is a working copy of the tree; keys
+// and values still own their heap memory, so it is not a flat image to
+// write out. Removed slots are reused by later inserts and Rebalance packs
+// the live nodes in preorder, so a parent sits next to its left child.
+//
+// Same ordering rules as SearchTree: KeyOf pulls the key out of a value,
+// Compare orders keys and equal keys go to the right.
+template <typename Key, typename Value, typename KeyOf, typename Compare = std::less<Key>>
+class IndexedTree {
+
+public:
+    // slot number of an empty link
+    static const uint32_t NIL = 0xffffffffu;
+
+private:
+    struct Hot {
+        Key key;
+        uint32_t left;
+        uint32_t right;
+    };
+
+    std::vector<Hot> hot;
+    std::vector<Value> cold;
+    std::vector<uint32_t> freeSlots;
+    uint32_t root;
+    size_t count;
+
+    static bool less(const Key& a, const Key& b) {
+        return Compare()(a, b);
+    }
+
+    // a slot holding value with no children
+    uint32_t allocate(const Value& value) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            cold[slot] = value;
+        }
+        else {
+            slot = (uint32_t)hot.size();
+            hot.push_back(Hot());
+            cold.push_back(value);
+        }
+        hot[slot].key = KeyOf()(value);
+        hot[slot].left = NIL;
+        hot[slot].right = NIL;
+        return slot;
+    }
+
+    void release(uint32_t slot) {
+        hot[slot].key = Key();
+        cold[slot] = Value();
+        freeSlots.push_back(slot);
+    }
+
+    // every slot in key order
+    void flatten(std::vector<uint32_t>& slots) const {
+        std::vector<uint32_t> stack;
+        uint32_t node = root;
+        while (node != NIL || !stack.empty()) {
+            while (node != NIL) {
+                stack.push_back(node);
+                node = hot[node].left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            slots.push_back(node);
+            node = hot[node].right;
+        }
+    }
+
+    // copy slots[lo, hi) into the new vectors as a balanced subtree, parents first
+    uint32_t build(const std::vector<uint32_t>& slots, size_t lo, size_t hi, std::vector<Hot>& newHot,
+        std::vector<Value>& newCold) {
+        if (lo >= hi) {
+            return NIL;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t slot = (uint32_t)newHot.size();
+        newHot.push_back(Hot());
+        newHot[slot].key = std::move(hot[slots[mid]].key);
+        newCold.push_back(std::move(cold[slots[mid]]));
+        uint32_t left = build(slots, lo, mid, newHot, newCold);
+        uint32_t right = build(slots, mid + 1, hi, newHot, newCold);
+        newHot[slot].left = left;
+        newHot[slot].right = right;
+        return slot;
+    }
+
+public:
+    IndexedTree() {
+        root = NIL;
+        count = 0;
+    }
+
+    // Delete every value
+    void Clear() {
+        hot.clear();
+        cold.clear();
+        freeSlots.clear();
+        root = NIL;
+        count = 0;
+    }
+
+    // Number of values in the tree
+    size_t Size() const {
+        return count;
+    }
+
+    // Bytes of the key and link arrays, what a search walks
+    size_t HotBytes() const {
+        return hot.capacity() * sizeof(Hot);
+    }
+
+    // Bytes of the value array
+    size_t ColdBytes() const {
+        return cold.capacity() * sizeof(Value);
+    }
+
+    // Node count, deepest level and average level of the nodes, root is level 1
+    TreeShape Shape() const {
+        TreeShape shape;
+        shape.nodes = 0;
+        shape.maxDepth = 0;
+        size_t depthSum = 0;
+        std::vector<std::pair<uint32_t, size_t>> stack;
+        if (root != NIL) {
+            stack.push_back(std::make_pair(root, (size_t)1));
+        }
+        while (!stack.empty()) {
+            uint32_t node = stack.back().first;
+            size_t depth = stack.back().second;
+            stack.pop_back();
+            shape.nodes++;
+            depthSum += depth;
+            shape.maxDepth = depth > shape.maxDepth ? depth : shape.maxDepth;
+            if (hot[node].left != NIL) {
+                stack.push_back(std::make_pair(hot[node].left, depth + 1));
+            }
+            if (hot[node].right != NIL) {
+                stack.push_back(std::make_pair(hot[node].right, depth + 1));
+            }
+        }
+        shape.averageDepth = shape.nodes > 0 ? (double)depthSum / shape.nodes : 0;
+        return shape;
+    }
+
+    // Relink into a perfectly balanced tree stored in preorder, dropping free slots
+    void Rebalance() {
+        std::vector<uint32_t> slots;
+        slots.reserve(count);
+        flatten(slots);
+        std::vector<Hot> newHot;
+        std::vector<Value> newCold;
+        newHot.reserve(slots.size());
+        newCold.reserve(slots.size());
+        root = build(slots, 0, slots.size(), newHot, newCold);
+        hot.swap(newHot);
+        cold.swap(newCold);
+        freeSlots.clear();
+    }
+
+    // Visit every value in key order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        std::vector<uint32_t> stack;
+        uint32_t node = root;
+        while (node != NIL || !stack.empty()) {
+            // go as far left as possible
+            while (node != NIL) {
+                stack.push_back(node);
+                node = hot[node].left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            visit(cold[node]);
+            node = hot[node].right;
+        }
+    }
+
+    // Print every value in key order with displayRow
+    void InOrder() const {
+        InOrder([](const Value& value) {
+            displayRow(value);
+        });
+    }
+
+    // Insert a value
+    void Insert(const Value& value) {
+        // take the slot first, growing the vectors moves the links
+        uint32_t slot = allocate(value);
+        size_t compares = 0;
+        uint32_t* link = &root;
+        while (*link != NIL) {
+            compares++;
+            if (less(hot[slot].key, hot[*link].key)) {
+                link = &hot[*link].left;
+            }
+            else {
+                link = &hot[*link].right;
+            }
+        }
+        *link = slot;
+        count++;
+        CATALOG_METRIC(inserts, 1);
+        CATALOG_METRIC(insertComparisons, compares);
+    }
+
+    // Remove the value with a key
+    void Remove(const Key& key) {
+        // find the link pointing at the node to remove
+        size_t compares = 0;
+        uint32_t* link = &root;
+        while (*link != NIL) {
+            compares++;
+            if (less(key, hot[*link].key)) {
+                link = &hot[*link].left;
+                continue;
+            }
+            compares++;
+            if (less(hot[*link].key, key)) {
+                link = &hot[*link].right;
+            }
+            else {
+                break;
+            }
+        }
+        CATALOG_METRIC(removes, 1);
+        CATALOG_METRIC(removeComparisons, compares);
+        uint32_t node = *link;
+        if (node == NIL) {
+            return;
+        }
+
+        if (hot[node].left == NIL) {
+            *link = hot[node].right;
+        }
+        else if (hot[node].right == NIL) {
+            *link = hot[node].left;
+        }
+        else {
+            // two children, the smallest node on the right takes its place
+            uint32_t* successor = &hot[node].right;
+            while (hot[*successor].left != NIL) {
+                successor = &hot[*successor].left;
+            }
+            uint32_t next = *successor;
+            *successor = hot[next].right;
+            hot[next].left = hot[node].left;
+            hot[next].right = hot[node].right;
+            *link = next;
+        }
+        release(node);
+        count--;
+    }
+
+    // Find the value with a key, nullptr when there is none
+    const Value* Find(const Key& key) const {
+        size_t depth = 0;
+        size_t compares = 0;
+        uint32_t current = root;
+        while (current != NIL) {
+            depth++;
+            compares++;
+            if (less(key, hot[current].key)) {
+                current = hot[current].left;
+                continue;
+            }
+            compares++;
+            if (less(hot[current].key, key)) {
+                current = hot[current].right;
+            }
+            else {
+                break;
+            }
+        }
+        CATALOG_METRIC(searches, 1);
+        CATALOG_METRIC(searchDepth, depth);
+        CATALOG_METRIC(searchComparisons, compares);
+        return current != NIL ? &cold[current] : nullptr;
+    }
+
+    // Search for a value, a default constructed one when there is none
+    Value Search(const Key& key) const {
+        const Value* found = Find(key);
+        if (found != nullptr) {
+            return *found;
+        }
+        return Value();
+    }
+};
+
+#endif
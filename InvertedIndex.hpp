@@ -0,0 +1,290 @@
+//============================================================================
+// Name        : InvertedIndex.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef INVERTED_INDEX_HPP
+#define INVERTED_INDEX_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INVERTED_INDEX_SSE2 1
+#endif
+
+// Split text into lower case words made of letters and digits
+inline std::vector<std::string> tokenize(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) {
+            word.push_back((char)std::tolower(c));
+        }
+        else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Intersect two sorted lists of unique ids into out, returns the count
+//
+// The SSE2 loop compares four ids of a against all four rotations of a
+// block of b, then advances whichever block ends first.
+inline size_t intersectSorted(const uint32_t* a, size_t na,
+    const uint32_t* b, size_t nb, uint32_t* out) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t k = 0;
+#ifdef INVERTED_INDEX_SSE2
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+        __m128i match = _mm_cmpeq_epi32(va, vb);
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(match));
+        for (int bit = 0; bit < 4; bit++) {
+            if (mask & (1 << bit)) {
+                out[k++] = a[i + bit];
+            }
+        }
+        uint32_t lastA = a[i + 3];
+        uint32_t lastB = b[j + 3];
+        if (lastA <= lastB) {
+            i += 4;
+        }
+        if (lastB <= lastA) {
+            j += 4;
+        }
+    }
+#endif
+    // plain merge for whatever is left
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            i++;
+        }
+        else if (b[j] < a[i]) {
+            j++;
+        }
+        else {
+            out[k++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return k;
+}
+
+// Word -> course index over course names
+//
+// Every course gets a small id in insertion order. Each word keeps the ids
+// of the courses using it as a delta + varint encoded byte stream cut into
+// blocks of 128 ids, with the first id and byte offset of every block kept
+// uncompressed so a query only decodes the blocks it can match.
+class InvertedIndex {
+
+private:
+    static const uint32_t BLOCK = 128;
+
+    struct Postings {
+        std::vector<uint8_t> bytes;
+        std::vector<uint32_t> blockFirst;
+        std::vector<uint32_t> blockOffset;
+        uint32_t count;
+        uint32_t last;
+
+        Postings() {
+            count = 0;
+            last = 0;
+        }
+    };
+
+    std::unordered_map<std::string, Postings> terms;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> keys;
+    std::vector<std::string> names;
+    std::vector<bool> live;
+    uint32_t dead;
+
+    // append an id, ids always arrive in increasing order
+    static void append(Postings& list, uint32_t id) {
+        uint32_t delta;
+        if (list.count % BLOCK == 0) {
+            // new block restarts the deltas so it can be decoded on its own
+            list.blockFirst.push_back(id);
+            list.blockOffset.push_back((uint32_t)list.bytes.size());
+            delta = 0;
+        }
+        else {
+            delta = id - list.last;
+        }
+        while (delta >= 0x80) {
+            list.bytes.push_back((uint8_t)(delta | 0x80));
+            delta >>= 7;
+        }
+        list.bytes.push_back((uint8_t)delta);
+        list.last = id;
+        list.count++;
+    }
+
+    // decode one block into out, returns the number of ids
+    static uint32_t decodeBlock(const Postings& list, size_t block, uint32_t* out) {
+        uint32_t n = list.count - (uint32_t)block * BLOCK;
+        if (n > BLOCK) {
+            n = BLOCK;
+        }
+        const uint8_t* p = list.bytes.data() + list.blockOffset[block];
+        uint32_t id = list.blockFirst[block];
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t delta = 0;
+            int shift = 0;
+            while (*p & 0x80) {
+                delta |= (uint32_t)(*p++ & 0x7f) << shift;
+                shift += 7;
+            }
+            delta |= (uint32_t)(*p++) << shift;
+            id += delta;
+            out[i] = id;
+        }
+        return n;
+    }
+
+    // keep only the candidates that also appear in list
+    static void narrow(const Postings& list, std::vector<uint32_t>& candidates) {
+        uint32_t block[BLOCK];
+        std::vector<uint32_t> kept;
+        size_t c = 0;
+        size_t blocks = list.blockFirst.size();
+        for (size_t b = 0; b < blocks && c < candidates.size(); b++) {
+            // skip blocks that end before the next candidate
+            if (b + 1 < blocks && list.blockFirst[b + 1] <= candidates[c]) {
+                continue;
+            }
+            uint32_t end = b + 1 < blocks ? list.blockFirst[b + 1] : UINT32_MAX;
+            size_t stop = std::lower_bound(candidates.begin() + c, candidates.end(), end) - candidates.begin();
+            if (stop == c) {
+                continue;
+            }
+            uint32_t n = decodeBlock(list, b, block);
+            size_t at = kept.size();
+            kept.resize(at + (stop - c));
+            kept.resize(at + intersectSorted(candidates.data() + c, stop - c, block, n, kept.data() + at));
+            c = stop;
+        }
+        candidates.swap(kept);
+    }
+
+    void addWords(uint32_t id) {
+        std::vector<std::string> words = tokenize(names[id]);
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        for (size_t i = 0; i < words.size(); i++) {
+            append(terms[words[i]], id);
+        }
+    }
+
+    // renumber the live courses once removed ones outnumber them
+    void compact() {
+        std::vector<std::string> oldKeys;
+        std::vector<std::string> oldNames;
+        oldKeys.swap(keys);
+        oldNames.swap(names);
+        terms.clear();
+        ids.clear();
+        std::vector<bool> oldLive;
+        oldLive.swap(live);
+        dead = 0;
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldLive[i]) {
+                Add(oldKeys[i], oldNames[i]);
+            }
+        }
+    }
+
+public:
+    InvertedIndex() {
+        dead = 0;
+    }
+
+    // Index the words of a course name
+    void Add(const std::string& courseNum, const std::string& courseName) {
+        if (ids.find(courseNum) != ids.end()) {
+            Remove(courseNum);
+        }
+        uint32_t id = (uint32_t)keys.size();
+        ids[courseNum] = id;
+        keys.push_back(courseNum);
+        names.push_back(courseName);
+        live.push_back(true);
+        addWords(id);
+    }
+
+    // Drop a course, its ids stay in the lists until the next compaction
+    void Remove(const std::string& courseNum) {
+        auto found = ids.find(courseNum);
+        if (found == ids.end()) {
+            return;
+        }
+        live[found->second] = false;
+        names[found->second].clear();
+        ids.erase(found);
+        dead++;
+        if (dead > 1024 && dead > ids.size()) {
+            compact();
+        }
+    }
+
+    // Course numbers whose name contains every word of the query
+    std::vector<std::string> Search(const std::string& query) const {
+        std::vector<std::string> result;
+        std::vector<std::string> words = tokenize(query);
+        if (words.empty()) {
+            return result;
+        }
+
+        // look up every word, one missing word means no match
+        std::vector<const Postings*> lists;
+        for (size_t i = 0; i < words.size(); i++) {
+            auto found = terms.find(words[i]);
+            if (found == terms.end()) {
+                return result;
+            }
+            lists.push_back(&found->second);
+        }
+
+        // start from the shortest list so later lists decode the fewest blocks
+        std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) {
+            return a->count < b->count;
+        });
+        std::vector<uint32_t> candidates(lists[0]->count);
+        for (size_t b = 0; b < lists[0]->blockFirst.size(); b++) {
+            decodeBlock(*lists[0], b, candidates.data() + b * BLOCK);
+        }
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+            if (lists[i] != lists[i - 1]) {
+                narrow(*lists[i], candidates);
+            }
+        }
+
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (live[candidates[i]]) {
+                result.push_back(keys[candidates[i]]);
+            }
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,269 @@
+//============================================================================
+// Name        : LearnedIndex.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef LEARNED_INDEX_HPP
+#define LEARNED_INDEX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Order preserving integer codes for a set of keys
+//
+// Built from the keys it will be asked about: every byte they use gets a
+// small code in byte order, 0 is kept for the end of a key, and as many
+// codes as fit are packed into 64 bits. Course numbers use a few dozen
+// distinct bytes, so ten or more of their characters fit where a plain
+// big endian read would keep eight. A key before another never encodes
+// greater; keys that share every character that fits encode equal.
+class KeyEncoder {
+
+private:
+    uint8_t codes[256];     // code of each byte, 0 when the keys never use it
+    uint8_t below[256];     // for bytes the keys never use, the code of the closest used byte below
+    int bits;
+    int chars;
+
+public:
+    KeyEncoder() {
+        std::fill(codes, codes + 256, 0);
+        std::fill(below, below + 256, 0);
+        bits = 8;
+        chars = 8;
+    }
+
+    // Learn the alphabet of keys[0, count)
+    template <typename Key>
+    void Build(const Key* keys, size_t count) {
+        bool used[256] = {};
+        for (size_t i = 0; i < count; i++) {
+            for (size_t j = 0; j < keys[i].size(); j++) {
+                used[(unsigned char)keys[i][j]] = true;
+            }
+        }
+        int next = 0;
+        for (int b = 0; b < 256; b++) {
+            if (used[b]) {
+                next++;
+                codes[b] = (uint8_t)next;
+                below[b] = 0;
+            }
+            else {
+                codes[b] = 0;
+                below[b] = (uint8_t)next;
+            }
+        }
+        bits = 1;
+        while ((1 << bits) <= next) {
+            bits++;
+        }
+        chars = 64 / bits;
+    }
+
+    uint64_t Encode(const std::string& key) const {
+        uint64_t value = 0;
+        for (int i = 0; i < chars; i++) {
+            if ((size_t)i >= key.size()) {
+                // the empty key packs every code it does not have as 0
+                int rest = bits * (chars - i);
+                return rest == 64 ? 0 : value << rest;
+            }
+            unsigned char b = (unsigned char)key[i];
+            if (codes[b] == 0) {
+                // sort after every key with the closest used byte here and
+                // before every key with the next one
+                int rest = bits * (chars - i - 1);
+                value = value << bits | below[b];
+                return rest == 0 ? value : value << rest | (((uint64_t)1 << rest) - 1);
+            }
+            value = value << bits | codes[b];
+        }
+        return value;
+    }
+};
+
+// Learned index over a sorted array of integer keys
+//
+// A spline through a few (key, position) points, fitted in one pass with
+// a greedy error corridor so that the straight line between neighbouring
+// points puts every key within MAX_ERROR of its position. The points get
+// a spline of their own, and so on up until a level has a handful of
+// points. A lookup counts through the top level, then at every level
+// below reads one point, interpolates and counts through at most
+// 2 * MAX_ERROR + 3 entries, a cache line or two, to find the segment for
+// the next level or, at the bottom, the position in the array.
+class LearnedIndex {
+
+public:
+    static const size_t MAX_ERROR = 4;
+
+private:
+    // stop adding levels once one has this few points
+    static const size_t TOP = 16;
+
+    // spline points of one level: keys, where they sit in the level below
+    // and the slope of the segment ending at each
+    struct Level {
+        std::vector<uint64_t> keys;
+        std::vector<double> positions;
+        std::vector<double> slopes;
+    };
+
+    // levels[0] is fitted to the array, levels.back() is the top
+    std::vector<Level> levels;
+
+    // which side of the line from origin through (dx1, dy1) the point (dx2, dy2) is
+    static double cross(double dx1, double dy1, double dx2, double dy2) {
+        return dx1 * dy2 - dy1 * dx2;
+    }
+
+    // fit a spline to keys in increasing order, duplicates take their first position
+    static void fit(const uint64_t* keys, size_t count, Level& level) {
+        level.keys.push_back(keys[0]);
+        level.positions.push_back(0);
+        uint64_t previousKey = keys[0];
+        double previousPosition = 0;
+        // the corridor from the last point: lines through upper and lower
+        // keep every key since within MAX_ERROR
+        uint64_t upperKey = 0;
+        double upperPosition = 0;
+        uint64_t lowerKey = 0;
+        double lowerPosition = 0;
+        bool open = false;
+        for (size_t i = 1; i < count; i++) {
+            if (keys[i] == previousKey) {
+                continue;
+            }
+            double high = (double)i + MAX_ERROR;
+            double low = (double)i - MAX_ERROR;
+            if (open) {
+                uint64_t baseKey = level.keys.back();
+                double basePosition = level.positions.back();
+                double dx = (double)(keys[i] - baseKey);
+                double dy = (double)i - basePosition;
+                double upperDx = (double)(upperKey - baseKey);
+                double lowerDx = (double)(lowerKey - baseKey);
+                if (cross(upperDx, upperPosition - basePosition, dx, dy) > 0
+                    || cross(lowerDx, lowerPosition - basePosition, dx, dy) < 0) {
+                    // outside the corridor, the previous key ends the segment
+                    level.keys.push_back(previousKey);
+                    level.positions.push_back(previousPosition);
+                    upperKey = lowerKey = keys[i];
+                    upperPosition = high;
+                    lowerPosition = low;
+                }
+                else {
+                    // narrow the corridor to this key's bounds
+                    if (cross(upperDx, upperPosition - basePosition, dx, high - basePosition) < 0) {
+                        upperKey = keys[i];
+                        upperPosition = high;
+                    }
+                    if (cross(lowerDx, lowerPosition - basePosition, dx, low - basePosition) > 0) {
+                        lowerKey = keys[i];
+                        lowerPosition = low;
+                    }
+                }
+            }
+            else {
+                upperKey = lowerKey = keys[i];
+                upperPosition = high;
+                lowerPosition = low;
+                open = true;
+            }
+            previousKey = keys[i];
+            previousPosition = (double)i;
+        }
+        if (previousKey != level.keys.back()) {
+            level.keys.push_back(previousKey);
+            level.positions.push_back(previousPosition);
+        }
+        level.keys.shrink_to_fit();
+        level.positions.shrink_to_fit();
+        level.slopes.assign(level.keys.size(), 0);
+        for (size_t i = 1; i < level.keys.size(); i++) {
+            level.slopes[i] = (level.positions[i] - level.positions[i - 1]) / (double)(level.keys[i] - level.keys[i - 1]);
+        }
+    }
+
+    // first of keys[0, count) not below key, given a guess within MAX_ERROR
+    static size_t search(const uint64_t* keys, size_t count, uint64_t key, double guess) {
+        size_t center = guess <= 0 ? 0 : guess >= (double)count ? count : (size_t)guess;
+        size_t lo = center > MAX_ERROR + 1 ? center - MAX_ERROR - 1 : 0;
+        size_t hi = std::min(count, center + MAX_ERROR + 2);
+        // rounding or a long run of equal keys can leave the answer outside
+        // the window, binary search all of it when it did
+        if ((lo > 0 && keys[lo - 1] >= key) || (hi < count && keys[hi - 1] < key)) {
+            return std::lower_bound(keys, keys + count, key) - keys;
+        }
+        // the window is a few keys, counting them has no branch to mispredict
+        size_t at = lo;
+        for (size_t i = lo; i < hi; i++) {
+            at += keys[i] < key ? 1 : 0;
+        }
+        return at;
+    }
+
+    // where the segment of a level ending at point right puts key in the level below
+    static double predict(const Level& level, size_t right, uint64_t key) {
+        if (right == 0) {
+            return level.positions[0];
+        }
+        if (right == level.keys.size()) {
+            return level.positions.back() + 1;
+        }
+        return level.positions[right - 1] + level.slopes[right] * (double)(key - level.keys[right - 1]);
+    }
+
+public:
+    // Fit the index to keys in increasing order, duplicates allowed
+    void Build(const uint64_t* keys, size_t count) {
+        levels.clear();
+        if (count == 0) {
+            return;
+        }
+        levels.push_back(Level());
+        fit(keys, count, levels.back());
+        while (levels.back().keys.size() > TOP) {
+            Level upper;
+            fit(levels.back().keys.data(), levels.back().keys.size(), upper);
+            if (upper.keys.size() >= levels.back().keys.size()) {
+                break;
+            }
+            levels.push_back(std::move(upper));
+        }
+    }
+
+    // Position of the first of the count keys not below key, the same keys
+    // Build was given
+    size_t LowerBound(const uint64_t* keys, size_t count, uint64_t key) const {
+        if (count == 0) {
+            return 0;
+        }
+        const Level& top = levels.back();
+        size_t right = 0;
+        for (size_t i = 0; i < top.keys.size(); i++) {
+            right += top.keys[i] < key ? 1 : 0;
+        }
+        for (size_t l = levels.size() - 1; l > 0; l--) {
+            const Level& below = levels[l - 1];
+            right = search(below.keys.data(), below.keys.size(), key, predict(levels[l], right, key));
+        }
+        return search(keys, count, key, predict(levels[0], right, key));
+    }
+
+    // Bytes of every level
+    size_t Bytes() const {
+        size_t sum = 0;
+        for (size_t l = 0; l < levels.size(); l++) {
+            sum += levels[l].keys.capacity() * sizeof(uint64_t)
+                + (levels[l].positions.capacity() + levels[l].slopes.capacity()) * sizeof(double);
+        }
+        return sum;
+    }
+};
+
+#endif
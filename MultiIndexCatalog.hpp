@@ -0,0 +1,385 @@
+//============================================================================
+// Name        : MultiIndexCatalog.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef MULTI_INDEX_CATALOG_HPP
+#define MULTI_INDEX_CATALOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CatalogMetrics.hpp"
+#include "Course.hpp"
+
+// Orders a MultiIndexCatalog keeps its courses in
+enum CourseOrder {
+    BY_NUMBER,          // course number, the primary index
+    BY_NAME,            // course name, ties by course number
+    BY_DEPARTMENT,      // department, then as BY_NAME
+    ORDER_COUNT
+};
+
+// Courses held once and linked into one search tree per order
+//
+// Every node carries a course and a left and right link for each order,
+// so listing by name or by department walks a tree of the same nodes the
+// number index uses: nothing is copied out and sorted, and an Insert or
+// Remove relinks the one node in every index before it returns, so the
+// orders cannot disagree. Each index is a treap sharing one random
+// priority per node, which keeps every order about as deep as a balanced
+// tree whatever order the courses arrive in, without rebalancing.
+//
+// Course numbers are unique; inserting one that is already there replaces
+// its course, relinking the name orders only when the name changed.
+class MultiIndexCatalog {
+
+public:
+    struct Node {
+        Course course;
+        std::string department;     // leading letters of the course number
+        uint32_t priority;
+        Node* left[ORDER_COUNT];
+        Node* right[ORDER_COUNT];
+
+        Node(const Course& aCourse, uint32_t aPriority) : course(aCourse) {
+            department = departmentOf(course.courseNum);
+            priority = aPriority;
+            for (int o = 0; o < ORDER_COUNT; o++) {
+                left[o] = nullptr;
+                right[o] = nullptr;
+            }
+        }
+    };
+
+private:
+    Node* roots[ORDER_COUNT];
+    size_t count;
+    uint32_t seed;
+
+    // xorshift, priorities only need to look random to the input order
+    uint32_t nextPriority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    // whether a sorts before b in an order; the course number breaks every
+    // tie, so no two nodes are equal in any order
+    static bool before(int order, const Node* a, const Node* b) {
+        if (order == BY_DEPARTMENT && a->department != b->department) {
+            return a->department < b->department;
+        }
+        if (order != BY_NUMBER) {
+            int names = a->course.courseName.compare(b->course.courseName);
+            if (names != 0) {
+                return names < 0;
+            }
+        }
+        return a->course.courseNum < b->course.courseNum;
+    }
+
+    // split the subtree at node into the nodes before pivot and the rest
+    static void split(int order, Node* node, const Node* pivot, Node*& lo, Node*& hi) {
+        if (node == nullptr) {
+            lo = nullptr;
+            hi = nullptr;
+        }
+        else if (before(order, node, pivot)) {
+            split(order, node->right[order], pivot, node->right[order], hi);
+            lo = node;
+        }
+        else {
+            split(order, node->left[order], pivot, lo, node->left[order]);
+            hi = node;
+        }
+    }
+
+    // join two subtrees, every node of a before every node of b
+    static Node* merge(int order, Node* a, Node* b) {
+        if (a == nullptr || b == nullptr) {
+            return a != nullptr ? a : b;
+        }
+        if (a->priority > b->priority) {
+            a->right[order] = merge(order, a->right[order], b);
+            return a;
+        }
+        b->left[order] = merge(order, a, b->left[order]);
+        return b;
+    }
+
+    // link a node into the subtree at node, above the first node of lower priority
+    static Node* link(int order, Node* node, Node* fresh) {
+        if (node == nullptr) {
+            return fresh;
+        }
+        if (fresh->priority > node->priority) {
+            split(order, node, fresh, fresh->left[order], fresh->right[order]);
+            return fresh;
+        }
+        if (before(order, fresh, node)) {
+            node->left[order] = link(order, node->left[order], fresh);
+        }
+        else {
+            node->right[order] = link(order, node->right[order], fresh);
+        }
+        return node;
+    }
+
+    // take a node out of the subtree at node, its children join in its place
+    static Node* unlink(int order, Node* node, const Node* target) {
+        if (node == target) {
+            Node* joined = merge(order, node->left[order], node->right[order]);
+            node->left[order] = nullptr;
+            node->right[order] = nullptr;
+            return joined;
+        }
+        if (before(order, target, node)) {
+            node->left[order] = unlink(order, node->left[order], target);
+        }
+        else {
+            node->right[order] = unlink(order, node->right[order], target);
+        }
+        return node;
+    }
+
+    Node* find(const std::string& courseNum, size_t& levels) const {
+        Node* node = roots[BY_NUMBER];
+        levels = 0;
+        while (node != nullptr) {
+            levels++;
+            int compared = courseNum.compare(node->course.courseNum);
+            if (compared == 0) {
+                return node;
+            }
+            node = compared < 0 ? node->left[BY_NUMBER] : node->right[BY_NUMBER];
+        }
+        return nullptr;
+    }
+
+    // visit, in one order, every course from the first node below() is false
+    // for up to the last one past() is false for; below and past must
+    // split the order, a run of nodes for which both are false in between
+    template <typename Below, typename Past, typename Visit>
+    void walk(int order, Below below, Past past, Visit visit) const {
+        std::vector<const Node*> stack;
+        const Node* node = roots[order];
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                if (below(node)) {
+                    node = node->right[order];
+                }
+                else {
+                    stack.push_back(node);
+                    node = node->left[order];
+                }
+            }
+            if (stack.empty()) {
+                return;
+            }
+            node = stack.back();
+            stack.pop_back();
+            if (past(node)) {
+                return;
+            }
+            visit(node->course);
+            node = node->right[order];
+        }
+    }
+
+    static bool never(const Node*) {
+        return false;
+    }
+
+public:
+    MultiIndexCatalog() {
+        for (int o = 0; o < ORDER_COUNT; o++) {
+            roots[o] = nullptr;
+        }
+        count = 0;
+        seed = 2463534242u;
+    }
+
+    // the catalog owns its nodes
+    MultiIndexCatalog(const MultiIndexCatalog&) = delete;
+    MultiIndexCatalog& operator=(const MultiIndexCatalog&) = delete;
+
+    ~MultiIndexCatalog() {
+        Clear();
+    }
+
+    // Delete every course
+    void Clear() {
+        std::vector<Node*> nodes;
+        if (roots[BY_NUMBER] != nullptr) {
+            nodes.push_back(roots[BY_NUMBER]);
+        }
+        while (!nodes.empty()) {
+            Node* node = nodes.back();
+            nodes.pop_back();
+            if (node->left[BY_NUMBER] != nullptr) {
+                nodes.push_back(node->left[BY_NUMBER]);
+            }
+            if (node->right[BY_NUMBER] != nullptr) {
+                nodes.push_back(node->right[BY_NUMBER]);
+            }
+            CATALOG_METRIC(bytesFreed, sizeof(Node));
+            delete node;
+        }
+        for (int o = 0; o < ORDER_COUNT; o++) {
+            roots[o] = nullptr;
+        }
+        count = 0;
+    }
+
+    size_t Size() const {
+        return count;
+    }
+
+    // Depths of the course number index
+    TreeShape Shape() const {
+        TreeShape shape;
+        shape.nodes = 0;
+        shape.maxDepth = 0;
+        shape.averageDepth = 0;
+        size_t depthSum = 0;
+        std::vector<std::pair<const Node*, size_t>> stack;
+        if (roots[BY_NUMBER] != nullptr) {
+            stack.push_back(std::make_pair((const Node*)roots[BY_NUMBER], (size_t)1));
+        }
+        while (!stack.empty()) {
+            const Node* node = stack.back().first;
+            size_t depth = stack.back().second;
+            stack.pop_back();
+            shape.nodes++;
+            depthSum += depth;
+            if (depth > shape.maxDepth) {
+                shape.maxDepth = depth;
+            }
+            if (node->left[BY_NUMBER] != nullptr) {
+                stack.push_back(std::make_pair((const Node*)node->left[BY_NUMBER], depth + 1));
+            }
+            if (node->right[BY_NUMBER] != nullptr) {
+                stack.push_back(std::make_pair((const Node*)node->right[BY_NUMBER], depth + 1));
+            }
+        }
+        if (shape.nodes > 0) {
+            shape.averageDepth = (double)depthSum / shape.nodes;
+        }
+        return shape;
+    }
+
+    // Nothing to do, the priorities keep every index balanced
+    void Rebalance() {
+    }
+
+    // Insert a course, replacing the one with the same number
+    void Insert(const Course& course) {
+        size_t levels = 0;
+        Node* node = find(course.courseNum, levels);
+        if (node != nullptr) {
+            if (node->course.courseName == course.courseName) {
+                // same place in every order
+                node->course = course;
+            }
+            else {
+                for (int o = BY_NAME; o < ORDER_COUNT; o++) {
+                    roots[o] = unlink(o, roots[o], node);
+                }
+                node->course = course;
+                for (int o = BY_NAME; o < ORDER_COUNT; o++) {
+                    roots[o] = link(o, roots[o], node);
+                }
+            }
+            CATALOG_METRIC(inserts, 1);
+            CATALOG_METRIC(insertComparisons, levels);
+            return;
+        }
+        node = new Node(course, nextPriority());
+        for (int o = 0; o < ORDER_COUNT; o++) {
+            roots[o] = link(o, roots[o], node);
+        }
+        count++;
+        CATALOG_METRIC(inserts, 1);
+        CATALOG_METRIC(insertComparisons, levels);
+        CATALOG_METRIC(bytesAllocated, sizeof(Node));
+    }
+
+    // Remove the course with a number from every index
+    void Remove(const std::string& courseNum) {
+        size_t levels = 0;
+        Node* node = find(courseNum, levels);
+        CATALOG_METRIC(removes, 1);
+        CATALOG_METRIC(removeComparisons, levels);
+        if (node == nullptr) {
+            return;
+        }
+        for (int o = 0; o < ORDER_COUNT; o++) {
+            roots[o] = unlink(o, roots[o], node);
+        }
+        count--;
+        CATALOG_METRIC(bytesFreed, sizeof(Node));
+        delete node;
+    }
+
+    // Find the course with a number, nullptr when there is none
+    const Course* Find(const std::string& courseNum) const {
+        size_t levels = 0;
+        const Node* node = find(courseNum, levels);
+        CATALOG_METRIC(searches, 1);
+        CATALOG_METRIC(searchDepth, levels);
+        CATALOG_METRIC(searchComparisons, levels);
+        return node != nullptr ? &node->course : nullptr;
+    }
+
+    // Search for a course, a default constructed one when there is none
+    Course Search(const std::string& courseNum) const {
+        const Course* found = Find(courseNum);
+        return found != nullptr ? *found : Course();
+    }
+
+    // Visit every course in course number order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        walk(BY_NUMBER, never, never, visit);
+    }
+
+    // Print every course in course number order with displayRow
+    void InOrder() const {
+        InOrder([](const Course& course) {
+            displayRow(course);
+        });
+    }
+
+    // Visit every course with lo <= number <= hi in number order
+    template <typename Visit>
+    void Range(const std::string& lo, const std::string& hi, Visit visit) const {
+        walk(BY_NUMBER, [&lo](const Node* node) {
+            return node->course.courseNum < lo;
+        }, [&hi](const Node* node) {
+            return hi < node->course.courseNum;
+        }, visit);
+    }
+
+    // Visit every course in name order
+    template <typename Visit>
+    void ByName(Visit visit) const {
+        walk(BY_NAME, never, never, visit);
+    }
+
+    // Visit the courses of one department, "CSCI" for CSCI200, in name order
+    template <typename Visit>
+    void InDepartment(const std::string& department, Visit visit) const {
+        walk(BY_DEPARTMENT, [&department](const Node* node) {
+            return node->department < department;
+        }, [&department](const Node* node) {
+            return department < node->department;
+        }, visit);
+    }
+};
+
+#endif
@@ -0,0 +1,425 @@
+//============================================================================
+// Name        : PrereqGraph.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef PREREQ_GRAPH_HPP
+#define PREREQ_GRAPH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Course.hpp"
+
+// What validating the prerequisites found
+struct PrereqReport {
+    // groups of courses that (indirectly) require each other
+    std::vector<std::vector<std::string>> cycles;
+    // course and the prerequisite it names that is not in the catalog
+    std::vector<std::pair<std::string, std::string>> missing;
+    // every course with its layer: 0 has no prerequisites, layer k only
+    // needs courses from layers below k. Courses in a cycle share a layer.
+    std::vector<std::string> courses;
+    std::vector<uint32_t> layerOf;
+    uint32_t layers;
+};
+
+// Prerequisite graph of a catalog with cycle detection and layering
+//
+// Courses are numbered in key order and edges run from a course to each of
+// its prerequisites, stored both ways in compressed sparse row arrays.
+// Validate() first trims every course that cannot be on a cycle, finds the
+// strongly connected components of what is left with forward-backward
+// search, then layers the components with Kahn's algorithm. Each step
+// spreads its work over a pool of threads.
+class PrereqGraph {
+
+private:
+    std::vector<std::string> keys;
+    std::vector<std::pair<std::string, std::string>> missing;
+    // prerequisites of course v are prereqs[prereqStart[v] .. prereqStart[v + 1])
+    std::vector<uint32_t> prereqStart;
+    std::vector<uint32_t> prereqs;
+    // dependents of course v, the same edges reversed
+    std::vector<uint32_t> dependentStart;
+    std::vector<uint32_t> dependents;
+    unsigned threads;
+
+    static const uint32_t NONE = 0xffffffffu;
+
+    // call work(begin, end) on slices of [0, n) from every thread
+    void parallelFor(size_t n, const std::function<void(size_t, size_t)>& work) const {
+        size_t workers = std::min<size_t>(threads, (n + 1023) / 1024);
+        if (workers <= 1) {
+            work(0, n);
+            return;
+        }
+        std::vector<std::thread> pool;
+        size_t slice = (n + workers - 1) / workers;
+        for (size_t t = 0; t < workers; t++) {
+            size_t begin = t * slice;
+            size_t end = std::min(n, begin + slice);
+            if (begin < end) {
+                pool.emplace_back(work, begin, end);
+            }
+        }
+        for (size_t t = 0; t < pool.size(); t++) {
+            pool[t].join();
+        }
+    }
+
+    // Peel off courses with no live prerequisites or no live dependents,
+    // level by level, until only courses on or between cycles remain
+    void trim(std::vector<uint8_t>& alive) const {
+        size_t n = keys.size();
+        std::vector<std::atomic<uint32_t>> prereqsLeft(n);
+        std::vector<std::atomic<uint32_t>> dependentsLeft(n);
+        std::vector<uint32_t> frontier;
+        for (size_t v = 0; v < n; v++) {
+            prereqsLeft[v] = prereqStart[v + 1] - prereqStart[v];
+            dependentsLeft[v] = dependentStart[v + 1] - dependentStart[v];
+            if (prereqsLeft[v] == 0 || dependentsLeft[v] == 0) {
+                frontier.push_back((uint32_t)v);
+            }
+        }
+        std::vector<std::atomic<uint8_t>> removed(n);
+        for (size_t v = 0; v < n; v++) {
+            removed[v] = 0;
+        }
+        for (size_t i = 0; i < frontier.size(); i++) {
+            removed[frontier[i]] = 1;
+        }
+
+        std::mutex nextLock;
+        while (!frontier.empty()) {
+            std::vector<uint32_t> next;
+            parallelFor(frontier.size(), [&](size_t begin, size_t end) {
+                std::vector<uint32_t> local;
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t v = frontier[i];
+                    // v is gone, its neighbours lose an edge
+                    for (uint32_t e = prereqStart[v]; e < prereqStart[v + 1]; e++) {
+                        uint32_t p = prereqs[e];
+                        if (--dependentsLeft[p] == 0 && removed[p].exchange(1) == 0) {
+                            local.push_back(p);
+                        }
+                    }
+                    for (uint32_t e = dependentStart[v]; e < dependentStart[v + 1]; e++) {
+                        uint32_t d = dependents[e];
+                        if (--prereqsLeft[d] == 0 && removed[d].exchange(1) == 0) {
+                            local.push_back(d);
+                        }
+                    }
+                }
+                std::lock_guard<std::mutex> guard(nextLock);
+                next.insert(next.end(), local.begin(), local.end());
+            });
+            frontier.swap(next);
+        }
+        for (size_t v = 0; v < n; v++) {
+            alive[v] = removed[v] ? 0 : 1;
+        }
+    }
+
+    // Forward-backward search over the courses left after trimming
+    //
+    // A task owns a set of courses that share a color. From a pivot it
+    // marks everything reachable along prerequisites (forward) and along
+    // dependents (backward) inside the set; the courses marked both ways are
+    // the pivot's component. The three leftovers get new colors and become
+    // independent tasks, so tasks never touch the same course. A search
+    // still reads the colors of neighbours another task owns, and may be
+    // recoloring, so colors are relaxed atomics; a foreign color never
+    // equals the task's own, whichever value is read.
+    void components(const std::vector<uint8_t>& alive, std::vector<uint32_t>& component, uint32_t& componentCount) const {
+        size_t n = keys.size();
+        std::vector<std::atomic<uint32_t>> color(n);
+        std::vector<uint8_t> mark(n, 0);
+        std::vector<uint32_t> start;
+        for (size_t v = 0; v < n; v++) {
+            if (alive[v]) {
+                color[v].store(0, std::memory_order_relaxed);
+                start.push_back((uint32_t)v);
+            }
+            else {
+                color[v].store((uint32_t)NONE, std::memory_order_relaxed);
+            }
+        }
+        std::atomic<uint32_t> nextColor(1);
+        std::atomic<uint32_t> nextComponent(componentCount);
+
+        std::mutex lock;
+        std::condition_variable wake;
+        std::vector<std::vector<uint32_t>> tasks;
+        size_t running = 0;
+        if (!start.empty()) {
+            tasks.push_back(start);
+        }
+
+        auto reach = [&](uint32_t pivot, uint32_t c, uint8_t bit, const std::vector<uint32_t>& edgeStart,
+            const std::vector<uint32_t>& edges) {
+            std::vector<uint32_t> stack(1, pivot);
+            mark[pivot] |= bit;
+            while (!stack.empty()) {
+                uint32_t v = stack.back();
+                stack.pop_back();
+                for (uint32_t e = edgeStart[v]; e < edgeStart[v + 1]; e++) {
+                    uint32_t w = edges[e];
+                    if (color[w].load(std::memory_order_relaxed) == c && !(mark[w] & bit)) {
+                        mark[w] |= bit;
+                        stack.push_back(w);
+                    }
+                }
+            }
+        };
+
+        auto solve = [&](std::vector<uint32_t>& set) {
+            uint32_t c = color[set[0]].load(std::memory_order_relaxed);
+            reach(set[0], c, 1, prereqStart, prereqs);
+            reach(set[0], c, 2, dependentStart, dependents);
+            uint32_t id = nextComponent++;
+            std::vector<uint32_t> parts[3];
+            for (size_t i = 0; i < set.size(); i++) {
+                uint32_t v = set[i];
+                if (mark[v] == 3) {
+                    component[v] = id;
+                    color[v].store((uint32_t)NONE, std::memory_order_relaxed);
+                }
+                else {
+                    parts[mark[v]].push_back(v);
+                }
+                mark[v] = 0;
+            }
+            std::vector<std::vector<uint32_t>> more;
+            for (int p = 0; p < 3; p++) {
+                if (!parts[p].empty()) {
+                    uint32_t fresh = nextColor++;
+                    for (size_t i = 0; i < parts[p].size(); i++) {
+                        color[parts[p][i]].store(fresh, std::memory_order_relaxed);
+                    }
+                    more.push_back(std::move(parts[p]));
+                }
+            }
+            return more;
+        };
+
+        auto worker = [&]() {
+            std::unique_lock<std::mutex> guard(lock);
+            while (true) {
+                wake.wait(guard, [&]() { return !tasks.empty() || running == 0; });
+                if (tasks.empty()) {
+                    return;
+                }
+                std::vector<uint32_t> set = std::move(tasks.back());
+                tasks.pop_back();
+                running++;
+                guard.unlock();
+                std::vector<std::vector<uint32_t>> more = solve(set);
+                guard.lock();
+                running--;
+                for (size_t i = 0; i < more.size(); i++) {
+                    tasks.push_back(std::move(more[i]));
+                }
+                wake.notify_all();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (size_t t = 0; t < pool.size(); t++) {
+            pool[t].join();
+        }
+        componentCount = nextComponent;
+    }
+
+public:
+    PrereqGraph() {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Build the graph from anything with InOrder(visit) over courses
+    //
+    // The first walk collects the keys into an open addressed table of
+    // course ids, the second resolves every prerequisite through it.
+    template <typename Courses>
+    void Build(const Courses& source) {
+        keys.clear();
+        missing.clear();
+        source.InOrder([&](const Course& course) {
+            keys.push_back(course.courseNum);
+        });
+
+        size_t n = keys.size();
+        size_t mask = 1;
+        while (mask < n * 2) {
+            mask <<= 1;
+        }
+        mask--;
+        std::vector<uint32_t> table(mask + 1, (uint32_t)NONE);
+        std::hash<std::string> hash;
+        for (size_t v = 0; v < n; v++) {
+            size_t slot = hash(keys[v]) & mask;
+            while (table[slot] != NONE) {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = (uint32_t)v;
+        }
+        auto idOf = [&](const std::string& key) {
+            size_t slot = hash(key) & mask;
+            while (table[slot] != NONE && keys[table[slot]] != key) {
+                slot = (slot + 1) & mask;
+            }
+            return table[slot];
+        };
+
+        prereqStart.assign(n + 1, 0);
+        prereqs.clear();
+        std::vector<uint32_t> dependentCount(n + 1, 0);
+        size_t position = 0;
+        source.InOrder([&](const Course& course) {
+            prereqStart[position++] = (uint32_t)prereqs.size();
+            for (size_t i = 0; i < course.prereqs.size(); i++) {
+                uint32_t p = idOf(course.prereqs[i]);
+                if (p == NONE) {
+                    missing.push_back(std::make_pair(course.courseNum, course.prereqs[i]));
+                    continue;
+                }
+                prereqs.push_back(p);
+                dependentCount[p + 1]++;
+            }
+        });
+        prereqStart[n] = (uint32_t)prereqs.size();
+
+        // reverse edges by counting sort
+        for (size_t v = 0; v < n; v++) {
+            dependentCount[v + 1] += dependentCount[v];
+        }
+        dependentStart = dependentCount;
+        dependents.assign(prereqs.size(), 0);
+        std::vector<uint32_t> fill(dependentStart.begin(), dependentStart.end() - 1);
+        for (size_t v = 0; v < n; v++) {
+            for (uint32_t e = prereqStart[v]; e < prereqStart[v + 1]; e++) {
+                dependents[fill[prereqs[e]]++] = (uint32_t)v;
+            }
+        }
+    }
+
+    // Find the cycles and layer the catalog
+    PrereqReport Validate() const {
+        size_t n = keys.size();
+        PrereqReport report;
+        report.missing = missing;
+        report.courses = keys;
+        report.layers = 0;
+
+        // every trimmed course is a component on its own
+        std::vector<uint8_t> alive(n, 0);
+        trim(alive);
+        std::vector<uint32_t> component(n, (uint32_t)NONE);
+        uint32_t componentCount = 0;
+        for (size_t v = 0; v < n; v++) {
+            if (!alive[v]) {
+                component[v] = componentCount++;
+            }
+        }
+        components(alive, component, componentCount);
+
+        // members of component c are members[memberStart[c] .. memberStart[c + 1])
+        std::vector<uint32_t> memberStart(componentCount + 1, 0);
+        for (size_t v = 0; v < n; v++) {
+            memberStart[component[v] + 1]++;
+        }
+        for (uint32_t c = 0; c < componentCount; c++) {
+            memberStart[c + 1] += memberStart[c];
+        }
+        std::vector<uint32_t> members(n);
+        std::vector<uint32_t> fill(memberStart.begin(), memberStart.end() - 1);
+        for (size_t v = 0; v < n; v++) {
+            members[fill[component[v]]++] = (uint32_t)v;
+        }
+
+        // components with more than one course, or a course needing itself
+        for (uint32_t c = 0; c < componentCount; c++) {
+            uint32_t size = memberStart[c + 1] - memberStart[c];
+            bool cycle = size > 1;
+            if (size == 1) {
+                uint32_t v = members[memberStart[c]];
+                for (uint32_t e = prereqStart[v]; e < prereqStart[v + 1]; e++) {
+                    cycle = cycle || prereqs[e] == v;
+                }
+            }
+            if (cycle) {
+                std::vector<std::string> names;
+                for (uint32_t m = memberStart[c]; m < memberStart[c + 1]; m++) {
+                    names.push_back(keys[members[m]]);
+                }
+                report.cycles.push_back(names);
+            }
+        }
+
+        // Kahn layering of the component graph: a component is ready once
+        // every prerequisite edge leaving it points at a finished component
+        std::vector<std::atomic<uint32_t>> waiting(componentCount);
+        for (uint32_t c = 0; c < componentCount; c++) {
+            waiting[c] = 0;
+        }
+        for (size_t v = 0; v < n; v++) {
+            for (uint32_t e = prereqStart[v]; e < prereqStart[v + 1]; e++) {
+                if (component[prereqs[e]] != component[v]) {
+                    waiting[component[v]]++;
+                }
+            }
+        }
+        std::vector<uint32_t> layerOfComponent(componentCount, 0);
+        std::vector<uint32_t> frontier;
+        for (uint32_t c = 0; c < componentCount; c++) {
+            if (waiting[c] == 0) {
+                frontier.push_back(c);
+            }
+        }
+        std::mutex nextLock;
+        uint32_t layer = 0;
+        while (!frontier.empty()) {
+            std::vector<uint32_t> next;
+            parallelFor(frontier.size(), [&](size_t begin, size_t end) {
+                std::vector<uint32_t> local;
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t c = frontier[i];
+                    layerOfComponent[c] = layer;
+                    for (uint32_t m = memberStart[c]; m < memberStart[c + 1]; m++) {
+                        uint32_t v = members[m];
+                        for (uint32_t e = dependentStart[v]; e < dependentStart[v + 1]; e++) {
+                            uint32_t d = component[dependents[e]];
+                            if (d != c && --waiting[d] == 0) {
+                                local.push_back(d);
+                            }
+                        }
+                    }
+                }
+                std::lock_guard<std::mutex> guard(nextLock);
+                next.insert(next.end(), local.begin(), local.end());
+            });
+            frontier.swap(next);
+            layer++;
+        }
+        report.layers = layer;
+        report.layerOf.resize(n);
+        for (size_t v = 0; v < n; v++) {
+            report.layerOf[v] = layerOfComponent[component[v]];
+        }
+        return report;
+    }
+};
+
+#endif
@@ -0,0 +1,838 @@
+//============================================================================
+// Name        : RadixTree.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef RADIX_TREE_HPP
+#define RADIX_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BinarySearchTree.hpp"
+#include "CatalogMetrics.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RADIX_TREE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Adaptive radix tree over string keys
+//
+// The tree branches on one key byte per level instead of comparing whole
+// keys, so a search costs at most one step per byte no matter how many
+// courses there are. Inner nodes come in four sizes and grow or shrink as
+// children come and go: Node4 and Node16 keep sorted key bytes next to
+// their children (Node16 is searched with one SSE2 compare), Node48 maps
+// every byte to one of 48 child slots and Node256 is a plain array. Runs
+// of bytes every key below a node shares, like the department in CSCI101,
+// are stored once in the node instead of as a chain of one-child nodes.
+// Only the first MAX_PREFIX of them are kept; a search skips the rest and
+// the full key compare at the leaf catches a mismatch.
+//
+// Every key ends in a virtual 0 byte, so a key that is a prefix of another
+// (CS1 and CS10) still gets its own leaf and sorts first. Keys must not
+// contain 0 bytes themselves. Unlike SearchTree a key is held once, and
+// inserting a key that is already there replaces its value.
+template <typename Value, typename KeyOf>
+class RadixTree {
+
+private:
+    static const size_t MAX_PREFIX = 10;
+
+    enum NodeType : uint8_t {
+        NODE4,
+        NODE16,
+        NODE48,
+        NODE256
+    };
+
+    struct Node {
+        uint8_t type;
+        uint16_t count;                     // children in use
+        uint32_t prefixLength;              // shared bytes, may exceed MAX_PREFIX
+        unsigned char prefix[MAX_PREFIX];
+    };
+
+    struct Node4 : Node {
+        unsigned char keys[4];
+        Node* children[4];
+    };
+
+    struct Node16 : Node {
+        unsigned char keys[16];
+        Node* children[16];
+    };
+
+    struct Node48 : Node {
+        unsigned char slots[256];           // slot + 1 of each byte's child, 0 when none
+        Node* children[48];
+    };
+
+    struct Node256 : Node {
+        Node* children[256];
+    };
+
+    // leaves hang off the tree as tagged pointers, low bit set
+    struct Leaf {
+        Value value;
+    };
+
+    Node* root;
+    size_t count;
+    size_t nodeBytes;                       // inner nodes only
+
+    static bool isLeaf(const Node* node) {
+        return ((uintptr_t)node & 1) != 0;
+    }
+
+    static Leaf* asLeaf(const Node* node) {
+        return (Leaf*)((uintptr_t)node & ~(uintptr_t)1);
+    }
+
+    static Node* tag(Leaf* leaf) {
+        return (Node*)((uintptr_t)leaf | 1);
+    }
+
+    static const std::string& keyOf(const Leaf* leaf) {
+        return KeyOf()(leaf->value);
+    }
+
+    // byte of a key at a depth, the terminating 0 past its end
+    static unsigned char byteAt(const std::string& key, size_t depth) {
+        return depth < key.size() ? (unsigned char)key[depth] : 0;
+    }
+
+    template <typename T>
+    T* allocate(NodeType type) {
+        T* node = new T();
+        node->type = type;
+        nodeBytes += sizeof(T);
+        return node;
+    }
+
+    void release(Node* node) {
+        switch (node->type) {
+        case NODE4:
+            nodeBytes -= sizeof(Node4);
+            delete (Node4*)node;
+            break;
+        case NODE16:
+            nodeBytes -= sizeof(Node16);
+            delete (Node16*)node;
+            break;
+        case NODE48:
+            nodeBytes -= sizeof(Node48);
+            delete (Node48*)node;
+            break;
+        default:
+            nodeBytes -= sizeof(Node256);
+            delete (Node256*)node;
+        }
+    }
+
+    void destroy(Node* node) {
+        if (node == nullptr) {
+            return;
+        }
+        if (isLeaf(node)) {
+            delete asLeaf(node);
+            return;
+        }
+        eachChild(node, [this](unsigned char, Node* child) {
+            destroy(child);
+            return true;
+        });
+        release(node);
+    }
+
+    static void copyHeader(Node* to, const Node* from) {
+        to->count = from->count;
+        to->prefixLength = from->prefixLength;
+        memcpy(to->prefix, from->prefix, MAX_PREFIX);
+    }
+
+    // call visit(byte, child) for every child in byte order until it returns false
+    template <typename Visit>
+    static bool eachChild(const Node* node, Visit visit) {
+        switch (node->type) {
+        case NODE4: {
+            const Node4* n = (const Node4*)node;
+            for (int i = 0; i < n->count; i++) {
+                if (!visit(n->keys[i], n->children[i])) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case NODE16: {
+            const Node16* n = (const Node16*)node;
+            for (int i = 0; i < n->count; i++) {
+                if (!visit(n->keys[i], n->children[i])) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case NODE48: {
+            const Node48* n = (const Node48*)node;
+            for (int c = 0; c < 256; c++) {
+                if (n->slots[c] != 0 && !visit((unsigned char)c, n->children[n->slots[c] - 1])) {
+                    return false;
+                }
+            }
+            break;
+        }
+        default: {
+            const Node256* n = (const Node256*)node;
+            for (int c = 0; c < 256; c++) {
+                if (n->children[c] != nullptr && !visit((unsigned char)c, n->children[c])) {
+                    return false;
+                }
+            }
+        }
+        }
+        return true;
+    }
+
+    // index of the lowest set bit, bits is not 0
+    static int lowestBit(unsigned bits) {
+#ifdef _MSC_VER
+        unsigned long at;
+        _BitScanForward(&at, bits);
+        return (int)at;
+#else
+        return __builtin_ctz(bits);
+#endif
+    }
+
+    // position of the first of count sorted bytes not below c
+    static int lowerBound16(const unsigned char* keys, int count, unsigned char c) {
+#ifdef RADIX_TREE_SSE2
+        // SSE2 only compares signed bytes, flip the top bit to order them unsigned
+        __m128i flip = _mm_set1_epi8((char)0x80);
+        __m128i target = _mm_xor_si128(_mm_set1_epi8((char)c), flip);
+        __m128i bytes = _mm_xor_si128(_mm_loadu_si128((const __m128i*)keys), flip);
+        unsigned below = (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(bytes, target)) & ((1u << count) - 1);
+        // the keys are sorted, so the bytes below c are the low bits
+        return lowestBit(~below);
+#else
+        int i = 0;
+        while (i < count && keys[i] < c) {
+            i++;
+        }
+        return i;
+#endif
+    }
+
+    // the link to the child for byte c, nullptr when there is none
+    static Node** findChild(Node* node, unsigned char c) {
+        switch (node->type) {
+        case NODE4: {
+            Node4* n = (Node4*)node;
+            for (int i = 0; i < n->count; i++) {
+                if (n->keys[i] == c) {
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case NODE16: {
+            Node16* n = (Node16*)node;
+#ifdef RADIX_TREE_SSE2
+            __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8((char)c), _mm_loadu_si128((const __m128i*)n->keys));
+            unsigned hits = (unsigned)_mm_movemask_epi8(match) & ((1u << n->count) - 1);
+            return hits != 0 ? &n->children[lowestBit(hits)] : nullptr;
+#else
+            for (int i = 0; i < n->count; i++) {
+                if (n->keys[i] == c) {
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+#endif
+        }
+        case NODE48: {
+            Node48* n = (Node48*)node;
+            return n->slots[c] != 0 ? &n->children[n->slots[c] - 1] : nullptr;
+        }
+        default: {
+            Node256* n = (Node256*)node;
+            return n->children[c] != nullptr ? &n->children[c] : nullptr;
+        }
+        }
+    }
+
+    static const Leaf* minimumLeaf(const Node* node) {
+        while (!isLeaf(node)) {
+            const Node* first = nullptr;
+            eachChild(node, [&first](unsigned char, Node* child) {
+                first = child;
+                return false;
+            });
+            node = first;
+        }
+        return asLeaf(node);
+    }
+
+    // byte i of a node's prefix, read from a leaf below when it was not kept
+    static unsigned char prefixByte(const Node* node, size_t depth, size_t i) {
+        if (i < MAX_PREFIX) {
+            return node->prefix[i];
+        }
+        return byteAt(keyOf(minimumLeaf(node)), depth + i);
+    }
+
+    // how many of the kept prefix bytes match the key
+    static size_t matchKept(const Node* node, const std::string& key, size_t depth) {
+        size_t kept = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+        size_t i = 0;
+        while (i < kept && node->prefix[i] == byteAt(key, depth + i)) {
+            i++;
+        }
+        return i;
+    }
+
+    // how many of all prefix bytes match the key, for inserts that must split exactly
+    static size_t matchPrefix(const Node* node, const std::string& key, size_t depth) {
+        size_t i = matchKept(node, key, depth);
+        if (i < MAX_PREFIX || node->prefixLength <= MAX_PREFIX) {
+            return i;
+        }
+        const std::string& other = keyOf(minimumLeaf(node));
+        while (i < node->prefixLength && byteAt(other, depth + i) == byteAt(key, depth + i)) {
+            i++;
+        }
+        return i;
+    }
+
+    void addChild(Node** link, Node* node, unsigned char c, Node* child) {
+        switch (node->type) {
+        case NODE4: {
+            Node4* n = (Node4*)node;
+            if (n->count < 4) {
+                int at = 0;
+                while (at < n->count && n->keys[at] < c) {
+                    at++;
+                }
+                memmove(n->keys + at + 1, n->keys + at, n->count - at);
+                memmove(n->children + at + 1, n->children + at, (n->count - at) * sizeof(Node*));
+                n->keys[at] = c;
+                n->children[at] = child;
+                n->count++;
+                return;
+            }
+            Node16* grown = allocate<Node16>(NODE16);
+            copyHeader(grown, n);
+            memcpy(grown->keys, n->keys, 4);
+            memcpy(grown->children, n->children, 4 * sizeof(Node*));
+            *link = grown;
+            release(n);
+            addChild(link, grown, c, child);
+            return;
+        }
+        case NODE16: {
+            Node16* n = (Node16*)node;
+            if (n->count < 16) {
+                int at = lowerBound16(n->keys, n->count, c);
+                memmove(n->keys + at + 1, n->keys + at, n->count - at);
+                memmove(n->children + at + 1, n->children + at, (n->count - at) * sizeof(Node*));
+                n->keys[at] = c;
+                n->children[at] = child;
+                n->count++;
+                return;
+            }
+            Node48* grown = allocate<Node48>(NODE48);
+            copyHeader(grown, n);
+            for (int i = 0; i < 16; i++) {
+                grown->children[i] = n->children[i];
+                grown->slots[n->keys[i]] = (unsigned char)(i + 1);
+            }
+            *link = grown;
+            release(n);
+            addChild(link, grown, c, child);
+            return;
+        }
+        case NODE48: {
+            Node48* n = (Node48*)node;
+            if (n->count < 48) {
+                // removals leave holes, take the first free slot
+                int slot = 0;
+                while (n->children[slot] != nullptr) {
+                    slot++;
+                }
+                n->children[slot] = child;
+                n->slots[c] = (unsigned char)(slot + 1);
+                n->count++;
+                return;
+            }
+            Node256* grown = allocate<Node256>(NODE256);
+            copyHeader(grown, n);
+            for (int b = 0; b < 256; b++) {
+                if (n->slots[b] != 0) {
+                    grown->children[b] = n->children[n->slots[b] - 1];
+                }
+            }
+            *link = grown;
+            release(n);
+            addChild(link, grown, c, child);
+            return;
+        }
+        default: {
+            Node256* n = (Node256*)node;
+            n->children[c] = child;
+            n->count++;
+        }
+        }
+    }
+
+    // unlink the child at slot from node, shrinking it when it gets sparse
+    void removeChild(Node** link, Node* node, unsigned char c, Node** slot) {
+        switch (node->type) {
+        case NODE4: {
+            Node4* n = (Node4*)node;
+            int at = (int)(slot - n->children);
+            memmove(n->keys + at, n->keys + at + 1, n->count - at - 1);
+            memmove(n->children + at, n->children + at + 1, (n->count - at - 1) * sizeof(Node*));
+            n->count--;
+            if (n->count == 1) {
+                // a single child takes the node's place, prefixes joined
+                Node* child = n->children[0];
+                if (!isLeaf(child)) {
+                    size_t length = n->prefixLength;
+                    if (length < MAX_PREFIX) {
+                        n->prefix[length] = n->keys[0];
+                        length++;
+                    }
+                    if (length < MAX_PREFIX) {
+                        size_t more = child->prefixLength < MAX_PREFIX - length ? child->prefixLength : MAX_PREFIX - length;
+                        memcpy(n->prefix + length, child->prefix, more);
+                        length += more;
+                    }
+                    memcpy(child->prefix, n->prefix, length < MAX_PREFIX ? length : MAX_PREFIX);
+                    child->prefixLength += n->prefixLength + 1;
+                }
+                *link = child;
+                release(n);
+            }
+            return;
+        }
+        case NODE16: {
+            Node16* n = (Node16*)node;
+            int at = (int)(slot - n->children);
+            memmove(n->keys + at, n->keys + at + 1, n->count - at - 1);
+            memmove(n->children + at, n->children + at + 1, (n->count - at - 1) * sizeof(Node*));
+            n->count--;
+            if (n->count == 3) {
+                Node4* shrunk = allocate<Node4>(NODE4);
+                copyHeader(shrunk, n);
+                memcpy(shrunk->keys, n->keys, 3);
+                memcpy(shrunk->children, n->children, 3 * sizeof(Node*));
+                *link = shrunk;
+                release(n);
+            }
+            return;
+        }
+        case NODE48: {
+            Node48* n = (Node48*)node;
+            n->children[n->slots[c] - 1] = nullptr;
+            n->slots[c] = 0;
+            n->count--;
+            if (n->count == 12) {
+                Node16* shrunk = allocate<Node16>(NODE16);
+                copyHeader(shrunk, n);
+                int at = 0;
+                for (int b = 0; b < 256; b++) {
+                    if (n->slots[b] != 0) {
+                        shrunk->keys[at] = (unsigned char)b;
+                        shrunk->children[at] = n->children[n->slots[b] - 1];
+                        at++;
+                    }
+                }
+                *link = shrunk;
+                release(n);
+            }
+            return;
+        }
+        default: {
+            Node256* n = (Node256*)node;
+            n->children[c] = nullptr;
+            n->count--;
+            // shrink below the size Node48 grows at, so one key cannot flip it back and forth
+            if (n->count == 37) {
+                Node48* shrunk = allocate<Node48>(NODE48);
+                copyHeader(shrunk, n);
+                int at = 0;
+                for (int b = 0; b < 256; b++) {
+                    if (n->children[b] != nullptr) {
+                        shrunk->children[at] = n->children[b];
+                        shrunk->slots[b] = (unsigned char)(at + 1);
+                        at++;
+                    }
+                }
+                *link = shrunk;
+                release(n);
+            }
+        }
+        }
+    }
+
+    // true when a new leaf was added, false when an existing value was replaced
+    bool insert(Node** link, const Value& value, const std::string& key, size_t depth) {
+        Node* node = *link;
+        if (node == nullptr) {
+            *link = tag(new Leaf{ value });
+            return true;
+        }
+
+        if (isLeaf(node)) {
+            Leaf* existing = asLeaf(node);
+            const std::string& other = keyOf(existing);
+            if (other == key) {
+                existing->value = value;
+                return false;
+            }
+            // split the leaf with a Node4 over the bytes both keys share
+            size_t shared = 0;
+            while (byteAt(other, depth + shared) == byteAt(key, depth + shared)) {
+                shared++;
+            }
+            Node4* split = allocate<Node4>(NODE4);
+            split->prefixLength = (uint32_t)shared;
+            for (size_t i = 0; i < shared && i < MAX_PREFIX; i++) {
+                split->prefix[i] = byteAt(key, depth + i);
+            }
+            Node* leaf = tag(new Leaf{ value });
+            *link = split;
+            addChild(link, split, byteAt(other, depth + shared), node);
+            addChild(link, split, byteAt(key, depth + shared), leaf);
+            return true;
+        }
+
+        if (node->prefixLength > 0) {
+            size_t matched = matchPrefix(node, key, depth);
+            if (matched < node->prefixLength) {
+                // the key leaves the prefix early, split it with a Node4 above
+                Node4* split = allocate<Node4>(NODE4);
+                split->prefixLength = (uint32_t)matched;
+                memcpy(split->prefix, node->prefix, matched < MAX_PREFIX ? matched : MAX_PREFIX);
+                unsigned char branch = prefixByte(node, depth, matched);
+                if (node->prefixLength <= MAX_PREFIX) {
+                    node->prefixLength -= (uint32_t)(matched + 1);
+                    memmove(node->prefix, node->prefix + matched + 1, node->prefixLength);
+                }
+                else {
+                    // the bytes now kept were not, read them from a leaf
+                    const std::string& other = keyOf(minimumLeaf(node));
+                    node->prefixLength -= (uint32_t)(matched + 1);
+                    for (size_t i = 0; i < node->prefixLength && i < MAX_PREFIX; i++) {
+                        node->prefix[i] = byteAt(other, depth + matched + 1 + i);
+                    }
+                }
+                *link = split;
+                addChild(link, split, branch, node);
+                addChild(link, split, byteAt(key, depth + matched), tag(new Leaf{ value }));
+                return true;
+            }
+            depth += node->prefixLength;
+        }
+
+        Node** child = findChild(node, byteAt(key, depth));
+        if (child != nullptr) {
+            return insert(child, value, key, depth + 1);
+        }
+        addChild(link, node, byteAt(key, depth), tag(new Leaf{ value }));
+        return true;
+    }
+
+    // unlink the leaf with a key, nullptr when there is none
+    Leaf* remove(Node** link, const std::string& key, size_t depth) {
+        Node* node = *link;
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (isLeaf(node)) {
+            // only reached for a leaf at the root
+            if (keyOf(asLeaf(node)) != key) {
+                return nullptr;
+            }
+            *link = nullptr;
+            return asLeaf(node);
+        }
+        size_t kept = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+        if (matchKept(node, key, depth) != kept) {
+            return nullptr;
+        }
+        depth += node->prefixLength;
+        if (depth > key.size()) {
+            return nullptr;
+        }
+        unsigned char c = byteAt(key, depth);
+        Node** child = findChild(node, c);
+        if (child == nullptr) {
+            return nullptr;
+        }
+        if (!isLeaf(*child)) {
+            return remove(child, key, depth + 1);
+        }
+        Leaf* leaf = asLeaf(*child);
+        if (keyOf(leaf) != key) {
+            return nullptr;
+        }
+        removeChild(link, node, c, child);
+        return leaf;
+    }
+
+    // visit every value below a node in key order until visit returns false
+    template <typename Visit>
+    static bool visitAll(const Node* node, Visit& visit) {
+        if (isLeaf(node)) {
+            visit(asLeaf(node)->value);
+            return true;
+        }
+        return eachChild(node, [&visit](unsigned char, Node* child) {
+            return visitAll(child, visit);
+        });
+    }
+
+    // visit the values below a node with lo <= key <= hi, false once past hi;
+    // checkLo and checkHi say whether the path so far still equals that bound
+    template <typename Visit>
+    static bool visitRange(const Node* node, size_t depth, bool checkLo, bool checkHi,
+        const std::string& lo, const std::string& hi, Visit& visit) {
+        if (!checkLo && !checkHi) {
+            return visitAll(node, visit);
+        }
+        if (isLeaf(node)) {
+            const std::string& key = keyOf(asLeaf(node));
+            if (checkHi && hi < key) {
+                return false;
+            }
+            if (!checkLo || !(key < lo)) {
+                visit(asLeaf(node)->value);
+            }
+            return true;
+        }
+        for (size_t i = 0; i < node->prefixLength; i++) {
+            unsigned char b = prefixByte(node, depth, i);
+            if (checkLo) {
+                unsigned char low = byteAt(lo, depth + i);
+                if (b < low) {
+                    return true;
+                }
+                checkLo = b == low;
+            }
+            if (checkHi) {
+                unsigned char high = byteAt(hi, depth + i);
+                if (b > high) {
+                    return false;
+                }
+                checkHi = b == high;
+            }
+        }
+        depth += node->prefixLength;
+        unsigned char low = byteAt(lo, depth);
+        unsigned char high = byteAt(hi, depth);
+        return eachChild(node, [&](unsigned char c, Node* child) {
+            if (checkLo && c < low) {
+                return true;
+            }
+            if (checkHi && c > high) {
+                return false;
+            }
+            return visitRange(child, depth + 1, checkLo && c == low, checkHi && c == high, lo, hi, visit);
+        });
+    }
+
+public:
+    RadixTree() {
+        root = nullptr;
+        count = 0;
+        nodeBytes = 0;
+    }
+
+    ~RadixTree() {
+        destroy(root);
+    }
+
+    RadixTree(const RadixTree&) = delete;
+    RadixTree& operator=(const RadixTree&) = delete;
+
+    // Delete every value
+    void Clear() {
+        destroy(root);
+        root = nullptr;
+        count = 0;
+    }
+
+    // Number of values in the tree
+    size_t Size() const {
+        return count;
+    }
+
+    // Bytes of the inner nodes, what a search walks before the leaf
+    size_t InnerBytes() const {
+        return nodeBytes;
+    }
+
+    // Bytes of the leaves
+    size_t LeafBytes() const {
+        return count * sizeof(Leaf);
+    }
+
+    // Values, deepest level and average level of the leaves; every inner
+    // node on the way counts as a level, root is level 1
+    TreeShape Shape() const {
+        TreeShape shape;
+        shape.nodes = 0;
+        shape.maxDepth = 0;
+        size_t depthSum = 0;
+        std::vector<std::pair<const Node*, size_t>> stack;
+        if (root != nullptr) {
+            stack.push_back(std::make_pair((const Node*)root, (size_t)1));
+        }
+        while (!stack.empty()) {
+            const Node* node = stack.back().first;
+            size_t depth = stack.back().second;
+            stack.pop_back();
+            if (isLeaf(node)) {
+                shape.nodes++;
+                depthSum += depth;
+                shape.maxDepth = depth > shape.maxDepth ? depth : shape.maxDepth;
+                continue;
+            }
+            eachChild(node, [&stack, depth](unsigned char, Node* child) {
+                stack.push_back(std::make_pair((const Node*)child, depth + 1));
+                return true;
+            });
+        }
+        shape.averageDepth = shape.nodes > 0 ? (double)depthSum / shape.nodes : 0;
+        return shape;
+    }
+
+    // Nothing to do, the shape of a radix tree follows from its keys alone
+    void Rebalance() {
+    }
+
+    // Visit every value in key order
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        if (root != nullptr) {
+            visitAll(root, visit);
+        }
+    }
+
+    // Print every value in key order with displayRow
+    void InOrder() const {
+        InOrder([](const Value& value) {
+            displayRow(value);
+        });
+    }
+
+    // Visit every value with lo <= key <= hi in key order
+    template <typename Visit>
+    void Range(const std::string& lo, const std::string& hi, Visit visit) const {
+        if (root != nullptr && !(hi < lo)) {
+            visitRange(root, 0, true, true, lo, hi, visit);
+        }
+    }
+
+    // Visit every value whose key starts with prefix in key order
+    template <typename Visit>
+    void Prefix(const std::string& prefix, Visit visit) const {
+        const Node* node = root;
+        size_t depth = 0;
+        while (node != nullptr && depth < prefix.size()) {
+            if (isLeaf(node)) {
+                if (keyOf(asLeaf(node)).compare(0, prefix.size(), prefix) == 0) {
+                    visit(asLeaf(node)->value);
+                }
+                return;
+            }
+            for (size_t i = 0; i < node->prefixLength && depth + i < prefix.size(); i++) {
+                if (prefixByte(node, depth, i) != (unsigned char)prefix[depth + i]) {
+                    return;
+                }
+            }
+            depth += node->prefixLength;
+            if (depth >= prefix.size()) {
+                break;
+            }
+            Node** child = findChild((Node*)node, (unsigned char)prefix[depth]);
+            node = child != nullptr ? *child : nullptr;
+            depth++;
+        }
+        if (node != nullptr) {
+            visitAll(node, visit);
+        }
+    }
+
+    // Insert a value, replacing the one with the same key
+    void Insert(const Value& value) {
+        if (insert(&root, value, KeyOf()(value), 0)) {
+            count++;
+        }
+        CATALOG_METRIC(inserts, 1);
+    }
+
+    // Remove the value with a key
+    void Remove(const std::string& key) {
+        Leaf* leaf = remove(&root, key, 0);
+        CATALOG_METRIC(removes, 1);
+        if (leaf != nullptr) {
+            delete leaf;
+            count--;
+        }
+    }
+
+    // Find the value with a key, nullptr when there is none
+    const Value* Find(const std::string& key) const {
+        const Node* node = root;
+        size_t depth = 0;
+        size_t levels = 0;
+        while (node != nullptr && !isLeaf(node)) {
+            levels++;
+            size_t kept = node->prefixLength < MAX_PREFIX ? node->prefixLength : MAX_PREFIX;
+            if (matchKept(node, key, depth) != kept) {
+                node = nullptr;
+                break;
+            }
+            depth += node->prefixLength;
+            if (depth > key.size()) {
+                node = nullptr;
+                break;
+            }
+            Node** child = findChild((Node*)node, byteAt(key, depth));
+            node = child != nullptr ? *child : nullptr;
+            depth++;
+        }
+        CATALOG_METRIC(searches, 1);
+        CATALOG_METRIC(searchDepth, levels + (node != nullptr ? 1 : 0));
+        if (node == nullptr) {
+            return nullptr;
+        }
+        // one full compare settles the bytes the levels skipped
+        CATALOG_METRIC(searchComparisons, 1);
+        const Leaf* leaf = asLeaf(node);
+        return keyOf(leaf) == key ? &leaf->value : nullptr;
+    }
+
+    // Search for a value, a default constructed one when there is none
+    Value Search(const std::string& key) const {
+        const Value* found = Find(key);
+        if (found != nullptr) {
+            return *found;
+        }
+        return Value();
+    }
+};
+
+#endif
@@ -0,0 +1,120 @@
+//============================================================================
+// Name        : ResultCache.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CatalogMetrics.hpp"
+
+// Bounded cache of formatted course output, split into locked shards
+//
+// Every shard is a CLOCK ring: a hit sets the entry's reference bit and
+// eviction sweeps the ring clearing bits until it finds one unset, which
+// approximates LRU without moving anything on a hit. Entries remember the
+// catalog generation they were formatted at; any insert or remove bumps
+// the generation so older entries read as misses and get replaced.
+class ResultCache {
+
+private:
+    struct Entry {
+        std::string key;
+        std::string text;
+        uint64_t generation;
+        bool referenced;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::vector<Entry> ring;
+        std::unordered_map<std::string, size_t> slots;
+        size_t hand;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t perShard;
+
+    Shard& shardOf(const std::string& key) {
+        return *shards[std::hash<std::string>()(key) % shards.size()];
+    }
+
+public:
+    explicit ResultCache(size_t capacity = 1024, size_t shardCount = 16) {
+        shardCount = shardCount > 0 ? shardCount : 1;
+        perShard = (capacity + shardCount - 1) / shardCount;
+        perShard = perShard > 0 ? perShard : 1;
+        for (size_t i = 0; i < shardCount; i++) {
+            shards.emplace_back(new Shard());
+            shards.back()->hand = 0;
+        }
+    }
+
+    // Cached text of a key formatted at this generation, false on a miss
+    bool Get(const std::string& key, uint64_t generation, std::string* text) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.slots.find(key);
+        if (found == shard.slots.end() || shard.ring[found->second].generation != generation) {
+            CATALOG_METRIC(cacheMisses, 1);
+            return false;
+        }
+        Entry& entry = shard.ring[found->second];
+        entry.referenced = true;
+        *text = entry.text;
+        CATALOG_METRIC(cacheHits, 1);
+        return true;
+    }
+
+    // Remember the text of a key formatted at a generation
+    void Put(const std::string& key, uint64_t generation, const std::string& text) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        size_t slot;
+        auto found = shard.slots.find(key);
+        if (found != shard.slots.end()) {
+            slot = found->second;
+        }
+        else if (shard.ring.size() < perShard) {
+            slot = shard.ring.size();
+            shard.ring.push_back(Entry());
+            shard.slots[key] = slot;
+        }
+        else {
+            // sweep for an entry not used since the hand last passed it
+            while (shard.ring[shard.hand].referenced) {
+                shard.ring[shard.hand].referenced = false;
+                shard.hand = (shard.hand + 1) % shard.ring.size();
+            }
+            slot = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.ring.size();
+            shard.slots.erase(shard.ring[slot].key);
+            shard.slots[key] = slot;
+        }
+        Entry& entry = shard.ring[slot];
+        entry.key = key;
+        entry.text = text;
+        entry.generation = generation;
+        entry.referenced = false;
+    }
+
+    // Drop every entry
+    void Clear() {
+        for (size_t i = 0; i < shards.size(); i++) {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            shards[i]->ring.clear();
+            shards[i]->slots.clear();
+            shards[i]->hand = 0;
+        }
+    }
+};
+
+#endif
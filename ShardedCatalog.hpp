@@ -0,0 +1,187 @@
+//============================================================================
+// Name        : ShardedCatalog.hpp
+// Author      : Paul Velazquez
+//============================================================================
+
+#ifndef SHARDED_CATALOG_HPP
+#define SHARDED_CATALOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Course.hpp"
+
+// Catalog split into independent trees by department
+//
+// A course belongs to the shard picked by hashing its department prefix
+// (the leading letters of the course number), so a department always sits
+// in one shard. Every shard has its own tree and reader/writer lock: a
+// lookup locks one shard, a reload of one shard leaves the others serving,
+// and each tree is only as deep as its share of the catalog.
+class ShardedCatalog {
+
+private:
+    struct Shard {
+        BinarySearchTree tree;
+        mutable std::shared_mutex lock;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    // run work(shard) for every shard on up to one thread per core
+    void parallelForShards(const std::function<void(size_t)>& work) {
+        size_t threads = std::max<size_t>(1, std::min<size_t>(shards.size(), std::thread::hardware_concurrency()));
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; t++) {
+            pool.emplace_back([&]() {
+                for (size_t shard = next++; shard < shards.size(); shard = next++) {
+                    work(shard);
+                }
+            });
+        }
+        for (size_t shard = next++; shard < shards.size(); shard = next++) {
+            work(shard);
+        }
+        for (size_t t = 0; t < pool.size(); t++) {
+            pool[t].join();
+        }
+    }
+
+    // build a balanced tree from a shard's courses, sorted and linked in
+    // one pass so courses in key order do not make a list first
+    static void build(BinarySearchTree& tree, const std::vector<Course>& courses) {
+        tree.InsertBatch(courses);
+    }
+
+public:
+    explicit ShardedCatalog(size_t shardCount = 16) {
+        for (size_t i = 0; i < std::max<size_t>(shardCount, 1); i++) {
+            shards.emplace_back(new Shard());
+        }
+    }
+
+    // Leading letters of a course number, "CSCI" for "CSCI200"
+    static std::string Department(const std::string& courseNum) {
+        return departmentOf(courseNum);
+    }
+
+    size_t ShardCount() const {
+        return shards.size();
+    }
+
+    // Shard a course number belongs to
+    size_t ShardOf(const std::string& courseNum) const {
+        return std::hash<std::string>()(Department(courseNum)) % shards.size();
+    }
+
+    // Split courses into one list per shard
+    std::vector<std::vector<Course>> Partition(const std::vector<Course>& courses) const {
+        std::vector<std::vector<Course>> parts(shards.size());
+        for (size_t i = 0; i < courses.size(); i++) {
+            parts[ShardOf(courses[i].courseNum)].push_back(courses[i]);
+        }
+        return parts;
+    }
+
+    // Replace the whole catalog, every shard is built on its own thread
+    void Load(const std::vector<Course>& courses) {
+        std::vector<std::vector<Course>> parts = Partition(courses);
+        parallelForShards([&](size_t shard) {
+            ReloadShard(shard, parts[shard]);
+        });
+    }
+
+    // Replace one shard; the new tree is built before the lock is taken
+    void ReloadShard(size_t shard, const std::vector<Course>& courses) {
+        BinarySearchTree fresh;
+        build(fresh, courses);
+        std::unique_lock<std::shared_mutex> guard(shards[shard]->lock);
+        shards[shard]->tree = std::move(fresh);
+    }
+
+    void Insert(const Course& course) {
+        Shard& shard = *shards[ShardOf(course.courseNum)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.tree.Insert(course);
+    }
+
+    void Remove(const std::string& courseNum) {
+        Shard& shard = *shards[ShardOf(courseNum)];
+        std::unique_lock<std::shared_mutex> guard(shard.lock);
+        shard.tree.Remove(courseNum);
+    }
+
+    // Search for a course, an empty one when there is none
+    Course Search(const std::string& courseNum) const {
+        const Shard& shard = *shards[ShardOf(courseNum)];
+        std::shared_lock<std::shared_mutex> guard(shard.lock);
+        return shard.tree.Search(courseNum);
+    }
+
+    size_t Size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < shards.size(); i++) {
+            std::shared_lock<std::shared_mutex> guard(shards[i]->lock);
+            total += shards[i]->tree.Size();
+        }
+        return total;
+    }
+
+    // Deepest shard, the worst case for a lookup
+    size_t MaxDepth() const {
+        size_t depth = 0;
+        for (size_t i = 0; i < shards.size(); i++) {
+            std::shared_lock<std::shared_mutex> guard(shards[i]->lock);
+            depth = std::max(depth, shards[i]->tree.Shape().maxDepth);
+        }
+        return depth;
+    }
+
+    // Visit every course in key order by merging the shards
+    //
+    // Every shard is read locked, always in shard order, for the whole walk.
+    // A heap holds the current course of each shard and the smallest one is
+    // visited next, so the walk costs O(n log shards).
+    template <typename Visit>
+    void InOrder(Visit visit) const {
+        std::vector<std::shared_lock<std::shared_mutex>> guards;
+        for (size_t i = 0; i < shards.size(); i++) {
+            guards.emplace_back(shards[i]->lock);
+        }
+
+        std::vector<BinarySearchTree::const_iterator> cursors;
+        for (size_t i = 0; i < shards.size(); i++) {
+            cursors.push_back(shards[i]->tree.begin());
+        }
+        auto later = [&](size_t a, size_t b) {
+            return cursors[b]->courseNum < cursors[a]->courseNum;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+        for (size_t i = 0; i < cursors.size(); i++) {
+            if (cursors[i] != shards[i]->tree.end()) {
+                heap.push(i);
+            }
+        }
+        while (!heap.empty()) {
+            size_t i = heap.top();
+            heap.pop();
+            visit(*cursors[i]);
+            ++cursors[i];
+            if (cursors[i] != shards[i]->tree.end()) {
+                heap.push(i);
+            }
+        }
+    }
+};
+
+#endif